@@ -0,0 +1,196 @@
+/**
+ * @file air_sensor.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-18
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include "hardware/clocks.h"
+#include "air_sensor.h"
+#include "air_sequence.pio.h"
+
+/** How many conversions the trigger channel starts before it has to be restarted (about a day at 48kHz) */
+#define AIR_TRIGGER_COUNT 0xFFFFFFFF
+
+/** The IR emitters of each beam, from bottom to top */
+static constexpr uint air_led_pins[NUM_AIR_SENSORS] = {
+    PIN_AIR_LED_0, PIN_AIR_LED_1, PIN_AIR_LED_2, PIN_AIR_LED_3, PIN_AIR_LED_4, PIN_AIR_LED_5
+};
+
+/** The lowest emitter pin, which is bit 0 of every step of the sequence */
+#define AIR_PIN_BASE PIN_AIR_LED_4
+
+static_assert(PIN_AIR_LED_0 >= AIR_PIN_BASE && PIN_AIR_LED_1 >= AIR_PIN_BASE && PIN_AIR_LED_2 >= AIR_PIN_BASE
+    && PIN_AIR_LED_3 >= AIR_PIN_BASE && PIN_AIR_LED_5 >= AIR_PIN_BASE, "AIR_PIN_BASE must be the lowest emitter pin");
+
+/** The multiplexer input read by the spare steps, which isn't wired to a receiver */
+#define AIR_SPARE_MUX_INPUT 7
+
+/**
+ * @brief Returns the sequence step that selects the given multiplexer input, with or without the emitter of that beam.
+ */
+static constexpr uint32_t sequence_step(uint8_t mux_input, bool emitter_on) {
+    return (mux_input << (PIN_MUX_0 - AIR_PIN_BASE))
+        | (emitter_on ? 1u << (air_led_pins[mux_input] - AIR_PIN_BASE) : 0);
+}
+
+/**
+ * @brief Construct a new AirSensor::AirSensor object, which starts sampling straight away. The beams are read from
+ * multiplexer inputs 0-5, in order.
+ * @param pio The PIO block to drive the emitters and the multiplexer from
+ */
+AirSensor::AirSensor(PIO pio) :
+    samples(), adc_start_word(0), pio(pio), state_machine(0), samples_before_restart(0), states(0), levels(),
+    ambient_levels() {
+    uint32_t pin_mask = (1u << PIN_MUX_0) | (1u << PIN_MUX_1) | (1u << PIN_MUX_2);
+
+    // Every beam is sampled with its emitter off and then on, and each emitter is only on for its own sample
+    for (uint8_t i = 0; i < NUM_AIR_SENSORS; i++) {
+        sequence[i * 2] = sequence_step(i, false);
+        sequence[(i * 2) + 1] = sequence_step(i, true);
+        pin_mask |= 1u << air_led_pins[i];
+        set_thresholds(i, AIR_TRIGGER_LEVEL, AIR_RELEASE_LEVEL);
+    }
+
+    for (uint8_t i = NUM_AIR_SENSORS * 2; i < AIR_SAMPLE_SLOTS; i++) {
+        sequence[i] = AIR_SPARE_MUX_INPUT << (PIN_MUX_0 - AIR_PIN_BASE);
+    }
+
+    // The pins are driven by a PIO state machine, since DMA can't write to the SIO GPIO registers
+    state_machine = pio_claim_unused_sm(pio, true);
+    uint offset = pio_add_program(pio, &air_sequence_program);
+    air_sequence_program_init(pio, state_machine, offset, AIR_PIN_BASE, pin_mask);
+    pio_sm_put(pio, state_machine, sequence[0]);
+
+    // Conversions are started one at a time by DMA, and each result is left in the FIFO for DMA to pick up
+    adc_init();
+    adc_gpio_init(PIN_AIR_SENSOR_IN);
+    adc_select_input(PIN_AIR_SENSOR_IN - 26);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_fifo_drain();
+    adc_start_word = adc_hw->cs | ADC_CS_START_ONCE_BITS;
+
+    trigger_channel = dma_claim_unused_channel(true);
+    sample_channel = dma_claim_unused_channel(true);
+    mux_channel = dma_claim_unused_channel(true);
+    dma_timer = dma_claim_unused_timer(true);
+    dma_timer_set_fraction(dma_timer, 1, clock_get_hz(clk_sys) / AIR_SAMPLE_RATE_HZ);
+
+    // Sample channel: moves one result from the ADC FIFO into the next slot of the ring, then steps the sequence
+    dma_channel_config sample_config = dma_channel_get_default_config(sample_channel);
+    channel_config_set_transfer_data_size(&sample_config, DMA_SIZE_16);
+    channel_config_set_read_increment(&sample_config, false);
+    channel_config_set_write_increment(&sample_config, true);
+    channel_config_set_ring(&sample_config, true, __builtin_ctz(sizeof(samples)));
+    channel_config_set_dreq(&sample_config, DREQ_ADC);
+    channel_config_set_chain_to(&sample_config, mux_channel);
+    dma_channel_configure(sample_channel, &sample_config, samples, &adc_hw->fifo, 1, false);
+
+    // Mux channel: writes the pins for the next slot to the PIO, then re-arms the sample channel
+    dma_channel_config mux_config = dma_channel_get_default_config(mux_channel);
+    channel_config_set_transfer_data_size(&mux_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&mux_config, true);
+    channel_config_set_write_increment(&mux_config, false);
+    channel_config_set_ring(&mux_config, false, __builtin_ctz(sizeof(sequence)));
+    channel_config_set_dreq(&mux_config, pio_get_dreq(pio, state_machine, true));
+    channel_config_set_chain_to(&mux_config, sample_channel);
+    dma_channel_configure(mux_channel, &mux_config, &pio->txf[state_machine], &sequence[1], 1, false);
+
+    dma_channel_start(sample_channel);
+    start_triggers();
+}
+
+/**
+ * @brief Starts the channel that writes to the ADC control register on every tick of a DMA timer, so a conversion
+ * is started at AIR_SAMPLE_RATE_HZ.
+ */
+void AirSensor::start_triggers() {
+    dma_channel_config trigger_config = dma_channel_get_default_config(trigger_channel);
+    channel_config_set_transfer_data_size(&trigger_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&trigger_config, false);
+    channel_config_set_write_increment(&trigger_config, false);
+    channel_config_set_dreq(&trigger_config, dma_get_timer_dreq(dma_timer));
+    dma_channel_configure(trigger_channel, &trigger_config, &adc_hw->cs, &adc_start_word, AIR_TRIGGER_COUNT, true);
+}
+
+/**
+ * @brief Reads the latest level of every beam and updates which beams are blocked. This only reads memory the DMA
+ * has already filled in, so it can be called as often as needed.
+ */
+void AirSensor::update() {
+    // The trigger channel stops after AIR_TRIGGER_COUNT conversions, so keep the total going across restarts
+    if (!dma_channel_is_busy(trigger_channel)) {
+        samples_before_restart += AIR_TRIGGER_COUNT;
+        start_triggers();
+    }
+
+    uint8_t blocked = states;
+
+    for (uint8_t i = 0; i < NUM_AIR_SENSORS; i++) {
+        // Whether light pulls the receiver output up or down, the difference is how much the emitter adds
+        uint16_t off = samples[i * 2];
+        uint16_t on = samples[(i * 2) + 1];
+        uint16_t level = on > off ? on - off : off - on;
+        levels[i] = level;
+        ambient_levels[i] = off;
+
+        // Hysteresis keeps a beam from flickering while a hand is right at the edge of it
+        if (level < trigger_levels[i]) {
+            blocked |= 1 << i;
+        } else if (level > release_levels[i]) {
+            blocked &= ~(1 << i);
+        }
+    }
+
+    // Publish every beam at once, so a reader never sees a mask with only some of them updated
+    states = blocked;
+}
+
+/**
+ * @brief Sets the thresholds of every beam relative to its current level, so this must only be called while none
+ * of the beams are blocked, such as right after boot.
+ */
+void AirSensor::calibrate() {
+    update();
+
+    for (uint8_t i = 0; i < NUM_AIR_SENSORS; i++) {
+        set_thresholds(i, (levels[i] * AIR_TRIGGER_PERCENT) / 100, (levels[i] * AIR_RELEASE_PERCENT) / 100);
+    }
+}
+
+/**
+ * @brief Sets the levels a beam has to drop below to count as blocked, and rise above to count as clear again.
+ */
+void AirSensor::set_thresholds(uint8_t beam, uint16_t trigger_level, uint16_t release_level) {
+    trigger_levels[beam] = trigger_level;
+    release_levels[beam] = release_level;
+}
+
+/**
+ * @brief Returns which beams were blocked as of the last update(), one bit per beam with bit 0 being the bottom one.
+ */
+uint8_t AirSensor::get_states() {
+    return states;
+}
+
+/**
+ * @brief Returns whether the given beam was blocked as of the last update().
+ */
+bool AirSensor::is_blocked(uint8_t beam) {
+    return bit_read(states, beam);
+}
+
+/**
+ * @brief Returns how many ADC samples have been taken in total, across every step of the sequence.
+ */
+uint32_t AirSensor::get_sample_count() {
+    return samples_before_restart + (AIR_TRIGGER_COUNT - dma_channel_hw_addr(trigger_channel)->transfer_count);
+}
+
+/**
+ * @brief Returns how many times every beam has had a new level sampled in total (once per pass over the sequence).
+ * The difference between two calls a second apart is the achieved per-beam update rate.
+ */
+uint32_t AirSensor::get_beam_update_count() {
+    return get_sample_count() / AIR_SAMPLE_SLOTS;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file air_sensor.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-18
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "../config.h"
+
+/** How many IR beams the air towers have, from 0 at the bottom to 5 at the top */
+#define NUM_AIR_SENSORS 6
+
+/**
+ * How many samples make up one pass over every beam: an emitter-off and an emitter-on sample for each beam, plus 4
+ * spare samples with every emitter off, to keep the sequence a power of 2 long for the DMA rings.
+ */
+#define AIR_SAMPLE_SLOTS 16
+
+/** How many ADC samples to take per second, across all slots. Each beam gets a new level once per pass. */
+#define AIR_SAMPLE_RATE_HZ 48000
+
+/** How many new levels each beam gets per second */
+#define AIR_BEAM_RATE_HZ (AIR_SAMPLE_RATE_HZ / AIR_SAMPLE_SLOTS)
+
+/**
+ * Default thresholds, as differences between the emitter-on and emitter-off 12-bit ADC levels. A beam counts as
+ * blocked once its level drops below the trigger level, and as clear again once it rises above the release level.
+ */
+#define AIR_TRIGGER_LEVEL 400
+#define AIR_RELEASE_LEVEL 600
+
+/** Thresholds set by calibrate(), as percentages of the level of each beam while it's clear */
+#define AIR_TRIGGER_PERCENT 60
+#define AIR_RELEASE_PERCENT 75
+
+static_assert(PIN_MUX_1 == PIN_MUX_0 + 1 && PIN_MUX_2 == PIN_MUX_0 + 2, "The multiplexer pins must be consecutive");
+static_assert(PIN_MUX_2 - PIN_AIR_LED_4 < 10, "The emitter and multiplexer pins must fit in one 10-pin PIO window");
+static_assert(PIN_AIR_SENSOR_IN >= 26 && PIN_AIR_SENSOR_IN <= 29, "The air sensor input must be an ADC pin");
+
+/**
+ * @brief This class handles the IR sensors of the air towers. Sampling runs entirely in hardware: a DMA timer starts
+ * an ADC conversion at AIR_SAMPLE_RATE_HZ, another DMA channel moves each result from the ADC FIFO into a ring with a
+ * slot per step of the sample sequence, and that chains to a third channel which feeds the next step to a PIO state
+ * machine. Each step sets both the multiplexer address and the IR emitters, which then have until the next conversion
+ * to settle. Every beam is sampled once with its emitter off and once with it on, and the difference between the two
+ * is the beam's level, which cancels out ambient IR from the cabinet lighting. update() only has to read the latest
+ * samples out of the ring and apply the thresholds.
+ */
+class AirSensor {
+    private:
+        /** Latest ADC level of each step of the sequence, written by DMA. Aligned for the DMA write ring. */
+        alignas(AIR_SAMPLE_SLOTS * sizeof(uint16_t)) volatile uint16_t samples[AIR_SAMPLE_SLOTS];
+        /** Pin states for each step of the sequence, read by DMA. Aligned for the DMA read ring. */
+        alignas(AIR_SAMPLE_SLOTS * sizeof(uint32_t)) uint32_t sequence[AIR_SAMPLE_SLOTS];
+        /** Value written to the ADC control register to start a conversion */
+        uint32_t adc_start_word;
+
+        PIO pio;
+        uint state_machine;
+        uint trigger_channel;
+        uint sample_channel;
+        uint mux_channel;
+        uint dma_timer;
+        uint32_t samples_before_restart;
+
+        uint16_t trigger_levels[NUM_AIR_SENSORS];
+        uint16_t release_levels[NUM_AIR_SENSORS];
+        /** One bit per blocked beam. Read from the other core, so it's only ever written whole, once per update() */
+        volatile uint8_t states;
+
+        void start_triggers();
+    public:
+        /** Latest level of each beam (emitter on minus emitter off), as of the last update() */
+        uint16_t levels[NUM_AIR_SENSORS];
+        /** Latest emitter-off ADC level of each beam, as of the last update(), which is the ambient IR it sees */
+        uint16_t ambient_levels[NUM_AIR_SENSORS];
+
+        AirSensor(PIO pio);
+        void update();
+        void calibrate();
+        void set_thresholds(uint8_t beam, uint16_t trigger_level, uint16_t release_level);
+        uint8_t get_states();
+        bool is_blocked(uint8_t beam);
+        uint32_t get_sample_count();
+        uint32_t get_beam_update_count();
+};
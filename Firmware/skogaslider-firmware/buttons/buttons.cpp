@@ -0,0 +1,118 @@
+/**
+ * @file buttons.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-20
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include "hardware/sync.h"
+#include "buttons.h"
+
+/** The pin of each button, which reads low while the button is held */
+static const uint button_pins[NUM_BUTTONS] = { PIN_SW_TEST, PIN_SW_SERVICE, PIN_SW_FUNCTION };
+
+Buttons* Buttons::instance = NULL;
+
+/**
+ * @brief Construct a new Buttons::Buttons object, and starts listening for button edges. Buttons that are already held
+ * start out pressed, without counting as a press.
+ */
+Buttons::Buttons() :
+    last_change_us(), press_counts(), states(0) {
+    instance = this;
+
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+        gpio_init(button_pins[i]);
+        gpio_set_dir(button_pins[i], GPIO_IN);
+        gpio_pull_up(button_pins[i]);
+        gpio_set_irq_enabled_with_callback(
+            button_pins[i], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, &Buttons::gpio_callback);
+    }
+
+    // Give the pull-ups a moment to bring up any pins that aren't held, then take the starting states
+    busy_wait_us_32(100);
+    uint32_t now = time_us_32();
+
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+        if (!gpio_get(button_pins[i])) {
+            states |= 1 << i;
+            last_change_us[i] = now;
+        }
+    }
+}
+
+/**
+ * @brief Interrupt handler for every GPIO edge on this core, which passes button edges on to the instance.
+ */
+void Buttons::gpio_callback(uint gpio, uint32_t events) {
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+        if (button_pins[i] == gpio) {
+            instance->update_button(i, time_us_32());
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Takes the current level of a button as its state, unless it changed state within the debounce time. Only
+ * called with the button interrupts held off (from the interrupt itself, or with interrupts disabled).
+ */
+void Buttons::update_button(uint8_t button, uint32_t now_us) {
+    if (now_us - last_change_us[button] < BUTTON_DEBOUNCE_US) {
+        return;
+    }
+
+    bool pressed = !gpio_get(button_pins[button]);
+
+    if (pressed == bit_read(states, button)) {
+        return;
+    }
+
+    states ^= 1 << button;
+    last_change_us[button] = now_us;
+
+    if (pressed) {
+        press_counts[button] = press_counts[button] + 1;
+    }
+}
+
+/**
+ * @brief Returns which buttons are held, one bit per button in the order of the Button enum. An edge that was ignored
+ * during the debounce time (such as the final bounce of a release) is picked up here, once the debounce time is over.
+ */
+uint8_t Buttons::get_states() {
+    uint32_t interrupts = save_and_disable_interrupts();
+    uint32_t now = time_us_32();
+
+    for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+        update_button(i, now);
+    }
+
+    restore_interrupts(interrupts);
+    return states;
+}
+
+/**
+ * @brief Returns whether the given button is held.
+ */
+bool Buttons::is_pressed(Button button) {
+    return bit_read(get_states(), button);
+}
+
+/**
+ * @brief Returns how many times the given button has been pressed since boot.
+ */
+uint32_t Buttons::get_press_count(Button button) {
+    return press_counts[button];
+}
+
+/**
+ * @brief Returns how many microseconds the given button has been held for, or 0 if it isn't held.
+ */
+uint32_t Buttons::get_held_us(Button button) {
+    if (!is_pressed(button)) {
+        return 0;
+    }
+
+    return time_us_32() - last_change_us[button];
+}
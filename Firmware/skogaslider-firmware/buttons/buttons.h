@@ -0,0 +1,48 @@
+/**
+ * @file buttons.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-20
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+#include "../config.h"
+
+/** How long a button ignores further edges after it changes state, to ride out switch bounce */
+#define BUTTON_DEBOUNCE_US 5000
+
+/**
+ * @brief The functional buttons on the controller.
+ */
+enum Button {
+    BUTTON_TEST = 0,
+    BUTTON_SERVICE = 1,
+    BUTTON_FUNCTION = 2,
+    NUM_BUTTONS = 3
+};
+
+/**
+ * @brief This class handles the test, service and function buttons. The buttons are read from GPIO edge interrupts,
+ * so a press is seen as soon as it happens, rather than on the next poll. A button takes the state of the first edge
+ * straight away, and then ignores edges for BUTTON_DEBOUNCE_US. The interrupts are handled on the core that constructs
+ * this, and only one instance can exist.
+ */
+class Buttons {
+    private:
+        static Buttons* instance;
+        static void gpio_callback(uint gpio, uint32_t events);
+
+        volatile uint32_t last_change_us[NUM_BUTTONS];
+        volatile uint32_t press_counts[NUM_BUTTONS];
+        volatile uint8_t states;
+
+        void update_button(uint8_t button, uint32_t now_us);
+    public:
+        Buttons();
+        uint8_t get_states();
+        bool is_pressed(Button button);
+        uint32_t get_press_count(Button button);
+        uint32_t get_held_us(Button button);
+};
@@ -37,6 +37,13 @@
 // Pin for the output from the multiplexer (IR sensors)
 #define PIN_AIR_SENSOR_IN 26
 
+// LED power budget. WS2812Bs draw roughly LED_CHANNEL_MA per channel at full output, plus LED_IDLE_MA each when
+// off. The budget is what the LEDs may draw in total, with or without a second USB port plugged in for power.
+#define LED_CHANNEL_MA 16
+#define LED_IDLE_MA 1
+#define LED_CURRENT_BUDGET_USB_MA 300
+#define LED_CURRENT_BUDGET_AUX_MA 900
+
 // I2C configuration, ports and addresses
 #define I2C_PORT i2c0
 #define I2C_FREQUENCY 100000
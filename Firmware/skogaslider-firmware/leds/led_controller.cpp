@@ -5,23 +5,43 @@
  * @copyright Copyright (c) skogaby 2022
  */
 
+#include <string.h>
 #include "led_controller.h"
 
+static_assert(LED_CURRENT_BUDGET_USB_MA > NUM_RGB_LEDS * LED_IDLE_MA, "LED power budget is below the idle current");
+static_assert(LED_CURRENT_BUDGET_AUX_MA > NUM_RGB_LEDS * LED_IDLE_MA, "LED power budget is below the idle current");
+
 /**
  * @brief Construct a new LedController::LedController object
  * @param brightness How bright the strip should be, out of 255
  */
-LedController::LedController(uint8_t brightness) {
+LedController::LedController(uint8_t brightness) :
+    frame_period_us(0), max_latency_us(0), last_commit_us(0), oldest_pending_us(0), pending_since_us(), pending_sources(0),
+    brightness(brightness), interpolation_us(0), host_frame(), start_frame(), transition_start_us(), active_transitions(0),
+    start_brightness(brightness), target_brightness(brightness), interpolation_over_budget(false),
+    current_limited_frames(0) {
+    gpio_init(PIN_AUX_POWER_DETECT);
+    gpio_set_dir(PIN_AUX_POWER_DETECT, GPIO_IN);
+    gpio_pull_down(PIN_AUX_POWER_DETECT);
+
     led_strip = PicoLed::addLeds<PicoLed::WS2812B>(pio0, 0, PIN_RGB_LED, NUM_RGB_LEDS, PicoLed::FORMAT_GRB);
     led_strip.setBrightness(brightness);
+    led_strip.setGammaCorrection(true);
+    pixel_buffer = led_strip.getBuffer();
+    blit_cycles.reset();
+    show_cycles.reset();
+    interpolation_cycles.reset();
+    estimated_current_ma.reset();
+    reset_latency_stats();
 
     // Set the initial colors for the slider
-    for (int i = 0; i < 15; i++) {
+    for (uint8_t i = 0; i < NUM_DIVIDERS; i++) {
         set_key(i, YELLOW);
         set_divider(i, PURPLE);
     }
 
-    set_key(15, YELLOW);
+    set_key(NUM_KEYS - 1, YELLOW);
+    limit_current();
     led_strip.show();
 }
 
@@ -36,19 +56,16 @@ void LedController::set_all(uint8_t red, uint8_t green, uint8_t blue) {
  * @brief Sets the color of the LEDs for the given slider key.
  */
 void LedController::set_key(uint8_t key, uint8_t red, uint8_t green, uint8_t blue) {
-    uint8_t led_index = (key * 2) + key;
-    auto color = PicoLed::RGB(red, green, blue);
-    led_strip.setPixelColor(led_index, color);
-    led_strip.setPixelColor(led_index + 1, color);
+    LedSlot slot = led_map.keys[key];
+    led_strip.fill(PicoLed::RGB(red, green, blue), slot.first, slot.count);
 }
 
 /**
  * @brief Sets the color of the LEDs for the given divider.
  */
 void LedController::set_divider(uint8_t divider, uint8_t red, uint8_t green, uint8_t blue) {
-    uint8_t led_index = (2 * (divider + 1)) + divider;
-    auto color = PicoLed::RGB(red, green, blue);
-    led_strip.setPixelColor(led_index, color);
+    LedSlot slot = led_map.dividers[divider];
+    led_strip.fill(PicoLed::RGB(red, green, blue), slot.first, slot.count);
 }
 
 /**
@@ -57,30 +74,314 @@ void LedController::set_divider(uint8_t divider, uint8_t red, uint8_t green, uin
  * group 0 being on the bottom and group 2 being on the top.
  */
 void LedController::set_tower(uint8_t tower, uint8_t group, uint8_t red, uint8_t green, uint8_t blue) {
-    uint8_t led_index = 0;
-    auto color = PicoLed::RGB(red, green, blue);
+    LedSlot slot = led_map.tower_groups[(tower * NUM_TOWER_GROUPS) + group];
+    led_strip.fill(PicoLed::RGB(red, green, blue), slot.first, slot.count);
+}
+
+/**
+ * @brief Decodes the 31 BRG triples of a slider LED report straight into the LED chain, without going through
+ * PicoLed::Color and the per-pixel virtual calls of the strip.
+ */
+void LedController::blit_slider(const uint8_t* brg) {
+    uint32_t start = cycle_counter_read();
+
+    // When interpolating, the host colors are the target to blend to, rather than going straight to the LEDs
+    uint32_t* pixels = interpolation_us > 0 ? host_frame.pixels : pixel_buffer;
+
+    blit_brg_slots(pixels, brg, led_map.slider_report, NUM_SLIDER_LED_SLOTS);
+
+    if (interpolation_us > 0) {
+        begin_transition(HOST_REGION_SLIDER);
+    } else {
+        led_strip.bufferChanged(led_map.slider.first, led_map.slider.count);
+    }
+
+    blit_cycles.record(cycles_since(start));
+}
+
+/**
+ * @brief Decodes the 3 BRG triples for an air tower straight into the LED chain. Tower 0 is the left tower,
+ * 1 is the right tower, and the triples go from the bottom group to the top group.
+ */
+void LedController::blit_tower(uint8_t tower, const uint8_t* brg) {
+    uint32_t start = cycle_counter_read();
+    uint32_t* pixels = interpolation_us > 0 ? host_frame.pixels : pixel_buffer;
+
+    blit_brg_slots(pixels, brg, &led_map.tower_groups[tower * NUM_TOWER_GROUPS], NUM_TOWER_GROUPS);
 
-    // To make logic easier, the left tower is tower 0. However, the PCB itself is wired up with right tower
-    // first, so if tower is 0, offset the LED index by 9 to skip the right tower LEDs
-    if (tower == 0) {
-        led_index = 56 + (3 * group);
+    if (interpolation_us > 0) {
+        begin_transition((HostRegion) (HOST_REGION_TOWER_0 + tower));
     } else {
-        led_index = 47 + (3 * group);
+        led_strip.bufferChanged(led_map.towers[tower].first, led_map.towers[tower].count);
+    }
+
+    blit_cycles.record(cycles_since(start));
+}
+
+/**
+ * @brief Copies a complete frame into the LED chain, replacing every LED.
+ */
+void LedController::load_frame(const LedFrame* frame) {
+    memcpy(pixel_buffer, frame->pixels, sizeof(frame->pixels));
+    led_strip.bufferChanged(0, NUM_RGB_LEDS);
+}
+
+/**
+ * @brief Returns the range of the LED chain a host region covers.
+ */
+LedSlot LedController::host_region_range(uint8_t region) {
+    return region == HOST_REGION_SLIDER ? led_map.slider : led_map.towers[region - HOST_REGION_TOWER_0];
+}
+
+/**
+ * @brief Starts blending a host region from the colors currently on the LEDs (which may be part way through an
+ * earlier blend) to the latest host colors. LEDs that get much brighter skip the blend and change straight away.
+ */
+void LedController::begin_transition(HostRegion region) {
+    LedSlot range = host_region_range(region);
+
+    for (uint8_t i = range.first; i < range.first + range.count; i++) {
+        uint32_t current = pixel_buffer[i];
+        start_frame.pixels[i] = is_rising_edge(current, host_frame.pixels[i]) ? host_frame.pixels[i] : current;
+    }
+
+    // The brightness comes with the slider colors, so it blends along with them
+    if (region == HOST_REGION_SLIDER) {
+        uint8_t current = brightness;
+        start_brightness = target_brightness > current + INTERPOLATION_BYPASS_STEP ? target_brightness : current;
+    }
+
+    transition_start_us[region] = time_us_32();
+    active_transitions |= 1 << region;
+}
+
+/**
+ * @brief Writes the blended colors of every active host region to the LED chain, for the given point in time, and
+ * finishes the blends that have run for the whole interpolation window.
+ */
+void LedController::interpolate(uint32_t now_us) {
+    if (active_transitions == 0) {
+        return;
+    }
+
+    uint32_t start = cycle_counter_read();
+
+    for (uint8_t region = 0; region < HOST_REGION_COUNT; region++) {
+        if (!(active_transitions & (1 << region))) {
+            continue;
+        }
+
+        // The blend weight is 0-256 in fixed point, and a frame that went over budget finishes every blend
+        uint32_t elapsed = now_us - transition_start_us[region];
+        uint16_t weight = (interpolation_over_budget || elapsed >= interpolation_us)
+            ? 256
+            : (elapsed << 8) / interpolation_us;
+
+        LedSlot range = host_region_range(region);
+
+        blend_pixels(&pixel_buffer[range.first], &start_frame.pixels[range.first], &host_frame.pixels[range.first],
+            range.count, weight);
+
+        if (region == HOST_REGION_SLIDER) {
+            int16_t difference = target_brightness - start_brightness;
+            brightness = start_brightness + ((difference * weight) >> 8);
+        }
+
+        led_strip.bufferChanged(range.first, range.count);
+
+        if (weight == 256) {
+            active_transitions &= ~(1 << region);
+        }
     }
 
-    led_strip.fill(color, led_index, 3);
+    uint32_t cycles = cycles_since(start);
+    interpolation_cycles.record(cycles);
+    interpolation_over_budget = cycles > INTERPOLATION_MAX_CYCLES;
 }
 
 /**
- * @brief Changes the brightness of the LED strip to the given value.
+ * @brief Checks whether any channel gets brighter by more than INTERPOLATION_BYPASS_STEP between two GRB words.
+ */
+inline bool LedController::is_rising_edge(uint32_t from, uint32_t to) {
+    for (uint8_t shift = 8; shift < 32; shift += 8) {
+        if (((to >> shift) & 0xFF) > ((from >> shift) & 0xFF) + INTERPOLATION_BYPASS_STEP) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Changes the brightness of the LED strip to the given value, from the next frame. The strip may be shown
+ * dimmer than this to stay within the power budget.
  */
 void LedController::set_brightness(uint8_t brightness) {
-    led_strip.setBrightness(brightness);
+    // When interpolating, the brightness blends along with the next slider colors instead
+    if (interpolation_us > 0) {
+        target_brightness = brightness;
+    } else {
+        this->brightness = brightness;
+    }
 }
 
 /**
- * @brief Updates the physical LED strip to show the latest colors set in memory.
+ * @brief Estimates the current the next frame draws, and dims the strip if it would go over the power budget. The
+ * budget is higher when a second USB port is plugged in for power. The output level of the strip is kept up to
+ * date as pixels change, so frames within the budget only cost a few multiplications here.
+ */
+void LedController::limit_current() {
+    uint8_t applied = led_strip.getBrightness();
+    uint32_t level = led_strip.getOutputLevel();
+
+    // The output level scales with the brightness, so the level at the requested brightness can be worked out from
+    // the level at the brightness last applied, unless that was 0
+    if (applied != brightness) {
+        if (applied > 0) {
+            level = (level * brightness) / applied;
+        } else {
+            led_strip.setBrightness(brightness);
+            applied = brightness;
+            level = led_strip.getOutputLevel();
+        }
+    }
+
+    uint32_t budget_ma = gpio_get(PIN_AUX_POWER_DETECT) ? LED_CURRENT_BUDGET_AUX_MA : LED_CURRENT_BUDGET_USB_MA;
+    uint32_t idle_ma = NUM_RGB_LEDS * LED_IDLE_MA;
+    uint32_t current_ma = idle_ma + ((level * LED_CHANNEL_MA) / 255);
+    uint8_t limited = brightness;
+
+    if (current_ma > budget_ma) {
+        limited = (brightness * (budget_ma - idle_ma)) / (current_ma - idle_ma);
+        current_ma = idle_ma + (((level * LED_CHANNEL_MA) / 255) * limited) / brightness;
+        current_limited_frames++;
+    }
+
+    if (limited != applied) {
+        led_strip.setBrightness(limited);
+    }
+
+    estimated_current_ma.record(current_ma);
+}
+
+/**
+ * @brief Updates the physical LED strip to show the latest colors set in memory. The frame is sent by DMA, so
+ * this returns right away, and a frame sent while the previous one is still going out is queued behind it.
+ * Nothing is sent if the colors and brightness haven't changed since the last frame. The frame is dimmed first if
+ * it would draw more current than the power budget allows.
  */
 void LedController::update() {
+    uint32_t start = cycle_counter_read();
+    limit_current();
     led_strip.show();
+    show_cycles.record(cycles_since(start));
+}
+
+/**
+ * @brief Configures when submitted changes are sent to the LEDs. A frame is committed once frame_period_us has passed
+ * since the previous one, or once the oldest change has waited max_latency_us, whichever comes first. Either can be
+ * 0 to disable it.
+ */
+void LedController::set_frame_timing(uint32_t frame_period_us, uint32_t max_latency_us) {
+    this->frame_period_us = frame_period_us;
+    this->max_latency_us = max_latency_us;
+}
+
+/**
+ * @brief Sets how many microseconds the LEDs take to blend from one host frame to the next, or 0 to show host
+ * frames as soon as they're committed. Blending runs at the frame rate set by set_frame_timing().
+ */
+void LedController::set_interpolation(uint32_t interpolation_us) {
+    this->interpolation_us = interpolation_us;
+}
+
+/**
+ * @brief Records that the given source has changed the colors in memory. The change is sent to the LEDs together
+ * with any other pending changes by the next call to commit_if_due() that finds a frame due. This never touches
+ * the strip itself, so it's safe to call while handling packets.
+ */
+void LedController::submit(LedSource source) {
+    uint8_t source_bit = 1 << source;
+
+    // Latency is measured from the first change that hasn't been sent yet
+    if (!(pending_sources & source_bit)) {
+        uint32_t now = time_us_32();
+        pending_since_us[source] = now;
+
+        if (pending_sources == 0) {
+            oldest_pending_us = now;
+        }
+
+        pending_sources |= source_bit;
+    }
+}
+
+/**
+ * @brief Sends all pending changes to the LEDs as one frame, if one is due, blending towards the latest host colors
+ * if interpolation is enabled. Call this from the main loop.
+ * @return true if a frame was committed
+ */
+bool LedController::commit_if_due() {
+    // Blends in progress keep frames coming, even without new changes
+    if (pending_sources == 0 && active_transitions == 0) {
+        return false;
+    }
+
+    uint32_t now = time_us_32();
+    bool period_elapsed = frame_period_us > 0 && now - last_commit_us >= frame_period_us;
+    bool deadline_reached = pending_sources != 0 && max_latency_us > 0 && now - oldest_pending_us >= max_latency_us;
+
+    if (!period_elapsed && !deadline_reached) {
+        return false;
+    }
+
+    interpolate(now);
+    update();
+    last_commit_us = now;
+
+    for (uint8_t i = 0; i < LED_SOURCE_COUNT; i++) {
+        if (pending_sources & (1 << i)) {
+            source_latency_us[i].record(now - pending_since_us[i]);
+        }
+    }
+
+    pending_sources = 0;
+    return true;
+}
+
+/**
+ * @brief Resets the per-source latency statistics.
+ */
+void LedController::reset_latency_stats() {
+    for (uint8_t i = 0; i < LED_SOURCE_COUNT; i++) {
+        source_latency_us[i].reset();
+    }
+}
+
+/**
+ * @brief Returns how many frames have been sent to the LED strip since the counts were last reset.
+ */
+uint32_t LedController::frames_shown() {
+    return led_strip.getFramesShown();
+}
+
+/**
+ * @brief Returns how many calls to update() were skipped since the counts were last reset, because nothing changed.
+ */
+uint32_t LedController::frames_suppressed() {
+    return led_strip.getFramesSuppressed();
+}
+
+/**
+ * @brief Resets the shown and suppressed frame counts.
+ */
+void LedController::reset_frame_counts() {
+    led_strip.resetFrameCounts();
+}
+
+/**
+ * @brief Returns the underlying strip, so benchmarks can compare other strip implementations against it.
+ */
+PicoLed::PicoLedController& LedController::strip() {
+    return led_strip;
 }
@@ -10,15 +10,45 @@
 #include <PicoLed.hpp>
 #include "pico/stdlib.h"
 #include "../config.h"
-
-// The number of RGB LEDs (2 for each slider key, 1 for each slider divider, 9 for each air tower)
-#define NUM_RGB_LEDS ((16 * 2) + 15) + (2 * 9)
+#include "../perf/cycle_counter.h"
+#include "../perf/interp_kernels.h"
+#include "led_layout.h"
+#include "led_swap_chain.h"
 
 // Constants for lights, used during reactive lighting mode, calibration sequences, etc.
 #define BLUE 0, 0, 255
 #define YELLOW 255, 100, 0
 #define PURPLE 160, 32, 240
 
+/**
+ * @brief The places LED changes come from. Each is tracked separately by the frame commit scheduler, so the time from
+ * a change being submitted to it being sent to the LEDs can be measured per source.
+ */
+enum LedSource {
+    LED_SOURCE_SLIDER = 0,
+    LED_SOURCE_BOARD_0 = 1,
+    LED_SOURCE_BOARD_1 = 2,
+    LED_SOURCE_REACTIVE = 3,
+    LED_SOURCE_COUNT = 4
+};
+
+/**
+ * @brief The parts of the LED chain the host updates separately, each of which blends to its new colors on its own
+ * when interpolation is enabled.
+ */
+enum HostRegion {
+    HOST_REGION_SLIDER = 0,
+    HOST_REGION_TOWER_0 = 1,
+    HOST_REGION_TOWER_1 = 2,
+    HOST_REGION_COUNT = 3
+};
+
+// A channel that gets brighter than this in one host frame changes instantly instead of blending, so flashes stay sharp
+#define INTERPOLATION_BYPASS_STEP 96
+
+// Most cycles a frame of interpolation may take. If a frame goes over, every blend is finished on the next frame.
+#define INTERPOLATION_MAX_CYCLES 20000
+
 /**
  * @brief This is a low-level controller for the LEDs, which manages the mapping of setting a specific key, divider, or air tower light
  * without needing to know the indices in the overall LED chain. Logically, the slider has 16 keys with 15 dividers between them, but each
@@ -27,12 +57,61 @@
 class LedController {
     private:
         PicoLed::PicoLedController led_strip;
+        uint32_t* pixel_buffer;
+
+        uint32_t frame_period_us;
+        uint32_t max_latency_us;
+        uint32_t last_commit_us;
+        uint32_t oldest_pending_us;
+        uint32_t pending_since_us[LED_SOURCE_COUNT];
+        uint8_t pending_sources;
+        uint8_t brightness;
+
+        uint32_t interpolation_us;
+        LedFrame host_frame;
+        LedFrame start_frame;
+        uint32_t transition_start_us[HOST_REGION_COUNT];
+        uint8_t active_transitions;
+        uint8_t start_brightness;
+        uint8_t target_brightness;
+        bool interpolation_over_budget;
+
+        static bool is_rising_edge(uint32_t from, uint32_t to);
+        static LedSlot host_region_range(uint8_t region);
+        void begin_transition(HostRegion region);
+        void interpolate(uint32_t now_us);
+        void limit_current();
     public:
+        /** How many cycles it takes to decode an LED report into the LED chain */
+        CycleStats blit_cycles;
+        /** How many cycles a call to update() blocks the calling core for, and how often it's called */
+        CycleStats show_cycles;
+        /** How many microseconds it takes from a change being submitted to it being sent, for each source */
+        CycleStats source_latency_us[LED_SOURCE_COUNT];
+        /** How many cycles blending between host frames takes per LED frame */
+        CycleStats interpolation_cycles;
+        /** The estimated current the LEDs draw for each frame sent, in mA */
+        CycleStats estimated_current_ma;
+        /** How many frames had their brightness lowered to stay within the power budget */
+        uint32_t current_limited_frames;
+
         LedController(uint8_t brightness);
         void set_all(uint8_t red, uint8_t green, uint8_t blue);
         void set_key(uint8_t key, uint8_t red, uint8_t green, uint8_t blue);
         void set_divider(uint8_t divider, uint8_t red, uint8_t green, uint8_t blue);
         void set_tower(uint8_t tower, uint8_t group, uint8_t red, uint8_t green, uint8_t blue);
+        void blit_slider(const uint8_t* brg);
+        void blit_tower(uint8_t tower, const uint8_t* brg);
+        void load_frame(const LedFrame* frame);
         void set_brightness(uint8_t brightness);
         void update();
+        void set_frame_timing(uint32_t frame_period_us, uint32_t max_latency_us);
+        void set_interpolation(uint32_t interpolation_us);
+        void submit(LedSource source);
+        bool commit_if_due();
+        void reset_latency_stats();
+        uint32_t frames_shown();
+        uint32_t frames_suppressed();
+        void reset_frame_counts();
+        PicoLed::PicoLedController& strip();
 };
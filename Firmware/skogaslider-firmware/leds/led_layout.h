@@ -0,0 +1,213 @@
+/**
+ * @file led_layout.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-13
+ * @brief The physical layout of the LED chain, described once as a table of segments. Every index map the LED code
+ * uses is generated from this table at compile time, so a PCB revision with a different chain only needs a new table.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+// The logical parts of the controller that have LEDs
+#define NUM_KEYS 16
+#define NUM_DIVIDERS 15
+#define NUM_TOWERS 2
+#define NUM_TOWER_GROUPS 3
+
+// The number of LED slots in a slider LED report (16 keys and 15 dividers, alternating)
+#define NUM_SLIDER_LED_SLOTS (NUM_KEYS + NUM_DIVIDERS)
+
+/**
+ * @brief The kind of part a segment of the LED chain belongs to.
+ */
+enum LedSegmentType {
+    SEGMENT_KEY,
+    SEGMENT_DIVIDER,
+    SEGMENT_TOWER_GROUP
+};
+
+/**
+ * @brief A run of consecutive LEDs in the chain that always show the same color. For tower groups, the index is
+ * (tower * NUM_TOWER_GROUPS) + group, where tower 0 is the left tower and group 0 is the bottom group.
+ */
+struct LedSegment {
+    LedSegmentType type;
+    uint8_t index;
+    uint8_t offset;
+    uint8_t count;
+};
+
+/**
+ * @brief Where a logical part lands in the LED chain: the first LED index and how many LEDs it covers.
+ */
+struct LedSlot {
+    uint8_t first;
+    uint8_t count;
+};
+
+/**
+ * @brief The LED chain of the current PCB, in chain order. The slider comes first from the left, alternating between
+ * keys (2 LEDs each) and dividers (1 LED each), followed by the right air tower and then the left air tower (3 groups
+ * of 3 LEDs each, bottom to top).
+ */
+constexpr LedSegment led_layout[] = {
+    { SEGMENT_KEY, 0, 0, 2 }, { SEGMENT_DIVIDER, 0, 2, 1 },
+    { SEGMENT_KEY, 1, 3, 2 }, { SEGMENT_DIVIDER, 1, 5, 1 },
+    { SEGMENT_KEY, 2, 6, 2 }, { SEGMENT_DIVIDER, 2, 8, 1 },
+    { SEGMENT_KEY, 3, 9, 2 }, { SEGMENT_DIVIDER, 3, 11, 1 },
+    { SEGMENT_KEY, 4, 12, 2 }, { SEGMENT_DIVIDER, 4, 14, 1 },
+    { SEGMENT_KEY, 5, 15, 2 }, { SEGMENT_DIVIDER, 5, 17, 1 },
+    { SEGMENT_KEY, 6, 18, 2 }, { SEGMENT_DIVIDER, 6, 20, 1 },
+    { SEGMENT_KEY, 7, 21, 2 }, { SEGMENT_DIVIDER, 7, 23, 1 },
+    { SEGMENT_KEY, 8, 24, 2 }, { SEGMENT_DIVIDER, 8, 26, 1 },
+    { SEGMENT_KEY, 9, 27, 2 }, { SEGMENT_DIVIDER, 9, 29, 1 },
+    { SEGMENT_KEY, 10, 30, 2 }, { SEGMENT_DIVIDER, 10, 32, 1 },
+    { SEGMENT_KEY, 11, 33, 2 }, { SEGMENT_DIVIDER, 11, 35, 1 },
+    { SEGMENT_KEY, 12, 36, 2 }, { SEGMENT_DIVIDER, 12, 38, 1 },
+    { SEGMENT_KEY, 13, 39, 2 }, { SEGMENT_DIVIDER, 13, 41, 1 },
+    { SEGMENT_KEY, 14, 42, 2 }, { SEGMENT_DIVIDER, 14, 44, 1 },
+    { SEGMENT_KEY, 15, 45, 2 },
+    { SEGMENT_TOWER_GROUP, 3, 47, 3 }, { SEGMENT_TOWER_GROUP, 4, 50, 3 }, { SEGMENT_TOWER_GROUP, 5, 53, 3 },
+    { SEGMENT_TOWER_GROUP, 0, 56, 3 }, { SEGMENT_TOWER_GROUP, 1, 59, 3 }, { SEGMENT_TOWER_GROUP, 2, 62, 3 }
+};
+
+constexpr uint8_t NUM_LED_SEGMENTS = sizeof(led_layout) / sizeof(led_layout[0]);
+
+/**
+ * @brief Index maps from logical parts to the LED chain, generated from led_layout.
+ */
+struct LedLayoutMap {
+    LedSlot keys[NUM_KEYS];
+    LedSlot dividers[NUM_DIVIDERS];
+    LedSlot tower_groups[NUM_TOWERS * NUM_TOWER_GROUPS];
+    /** Slot i of a slider LED report, which starts at the right-hand side with the last key */
+    LedSlot slider_report[NUM_SLIDER_LED_SLOTS];
+    /** The range of the chain covered by the slider, and by each tower */
+    LedSlot slider;
+    LedSlot towers[NUM_TOWERS];
+    uint8_t num_leds;
+
+    constexpr LedLayoutMap() : keys(), dividers(), tower_groups(), slider_report(), slider(), towers(), num_leds(0) {
+        for (uint8_t i = 0; i < NUM_LED_SEGMENTS; i++) {
+            const LedSegment& segment = led_layout[i];
+            LedSlot slot = { segment.offset, segment.count };
+
+            switch (segment.type) {
+                case SEGMENT_KEY:
+                    keys[segment.index] = slot;
+                    break;
+                case SEGMENT_DIVIDER:
+                    dividers[segment.index] = slot;
+                    break;
+                case SEGMENT_TOWER_GROUP:
+                    tower_groups[segment.index] = slot;
+                    break;
+            }
+
+            num_leds += segment.count;
+        }
+
+        for (uint8_t i = 0; i < NUM_SLIDER_LED_SLOTS; i++) {
+            slider_report[i] = (i % 2 == 0) ? keys[(NUM_KEYS - 1) - (i / 2)] : dividers[(NUM_DIVIDERS - 1) - (i / 2)];
+        }
+
+        slider = span(keys, NUM_KEYS, dividers, NUM_DIVIDERS);
+
+        for (uint8_t tower = 0; tower < NUM_TOWERS; tower++) {
+            towers[tower] = span(&tower_groups[tower * NUM_TOWER_GROUPS], NUM_TOWER_GROUPS, NULL, 0);
+        }
+    }
+
+    /** The smallest range of the chain that covers all the given slots */
+    static constexpr LedSlot span(const LedSlot* a, uint8_t a_count, const LedSlot* b, uint8_t b_count) {
+        uint8_t first = 0xFF;
+        uint8_t last = 0;
+
+        for (uint8_t i = 0; i < a_count + b_count; i++) {
+            const LedSlot& slot = i < a_count ? a[i] : b[i - a_count];
+            first = slot.first < first ? slot.first : first;
+            last = slot.first + slot.count > last ? slot.first + slot.count : last;
+        }
+
+        return { first, (uint8_t) (last - first) };
+    }
+};
+
+constexpr LedLayoutMap led_map {};
+
+// The number of RGB LEDs in the chain
+#define NUM_RGB_LEDS (led_map.num_leds)
+
+/**
+ * @brief Checks that the segments tile the chain: each one starts where the previous one ended, and none is empty.
+ */
+constexpr bool led_layout_is_contiguous() {
+    uint8_t offset = 0;
+
+    for (uint8_t i = 0; i < NUM_LED_SEGMENTS; i++) {
+        if (led_layout[i].offset != offset || led_layout[i].count == 0) {
+            return false;
+        }
+
+        offset += led_layout[i].count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks that every logical part of the given type appears in the layout exactly once.
+ */
+constexpr bool led_layout_covers(LedSegmentType type, uint8_t count) {
+    for (uint8_t index = 0; index < count; index++) {
+        uint8_t found = 0;
+
+        for (uint8_t i = 0; i < NUM_LED_SEGMENTS; i++) {
+            if (led_layout[i].type == type && led_layout[i].index == index) {
+                found++;
+            }
+        }
+
+        if (found != 1) {
+            return false;
+        }
+    }
+
+    for (uint8_t i = 0; i < NUM_LED_SEGMENTS; i++) {
+        if (led_layout[i].type == type && led_layout[i].index >= count) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(led_layout_is_contiguous(), "LED layout segments must be in chain order, with no gaps or overlaps");
+static_assert(led_layout_covers(SEGMENT_KEY, NUM_KEYS), "LED layout must have every key exactly once");
+static_assert(led_layout_covers(SEGMENT_DIVIDER, NUM_DIVIDERS), "LED layout must have every divider exactly once");
+static_assert(led_layout_covers(SEGMENT_TOWER_GROUP, NUM_TOWERS * NUM_TOWER_GROUPS),
+    "LED layout must have every air tower group exactly once");
+/**
+ * @brief Adds up how many LEDs the given parts have in the layout. A tower of -1 counts every part of the type,
+ * otherwise only the groups of that tower are counted.
+ */
+constexpr uint8_t led_layout_count(LedSegmentType type, int8_t tower = -1) {
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < NUM_LED_SEGMENTS; i++) {
+        if (led_layout[i].type == type && (tower < 0 || led_layout[i].index / NUM_TOWER_GROUPS == tower)) {
+            count += led_layout[i].count;
+        }
+    }
+
+    return count;
+}
+
+static_assert(led_map.slider.count == led_layout_count(SEGMENT_KEY) + led_layout_count(SEGMENT_DIVIDER),
+    "The slider LEDs must be one run in the chain");
+static_assert(led_map.towers[0].count == led_layout_count(SEGMENT_TOWER_GROUP, 0)
+    && led_map.towers[1].count == led_layout_count(SEGMENT_TOWER_GROUP, 1),
+    "The LEDs of each air tower must be one run in the chain");
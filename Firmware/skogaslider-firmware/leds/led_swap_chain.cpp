@@ -0,0 +1,89 @@
+/**
+ * @file led_swap_chain.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-14
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include "led_swap_chain.h"
+
+/**
+ * @brief Construct a new LedSwapChain object. Frame 0 is the (empty) latest frame, which counts as already taken,
+ * the consumer starts out on it, and the producer starts on frame 1.
+ */
+LedSwapChain::LedSwapChain() :
+    frames(),
+    latest(0),
+    back(1),
+    latest_sequence(0),
+    reading(0),
+    read_sequence(0),
+    frames_published(0),
+    frames_replaced(0)
+{
+}
+
+/**
+ * @brief Returns the frame the producer should render into. It stays the same until the next publish().
+ */
+LedFrame* LedSwapChain::back_frame() {
+    return &frames[back];
+}
+
+/**
+ * @brief Publishes the back frame as the latest complete frame, and moves the producer on to a frame that the
+ * consumer isn't using. Producer side only.
+ */
+void LedSwapChain::publish() {
+    if (latest_sequence != read_sequence) {
+        frames_replaced++;
+    }
+
+    // Make sure the frame contents are visible to the other core before the index is
+    __dmb();
+    latest = back;
+    latest_sequence = latest_sequence + 1;
+    __dmb();
+    frames_published++;
+
+    // The third frame is the one that's neither the latest nor being read
+    uint8_t in_use = reading;
+    back = 3 - latest - in_use;
+
+    if (in_use == latest) {
+        back = (latest + 1) % 3;
+    }
+}
+
+/**
+ * @brief Takes the latest complete frame for reading, if one was published since the last call. The frame stays
+ * valid until the next call. Consumer side only.
+ * @return The new frame, or NULL if there's nothing new
+ */
+const LedFrame* LedSwapChain::take_latest() {
+    uint8_t index;
+    uint32_t sequence;
+
+    if (latest_sequence == read_sequence) {
+        return NULL;
+    }
+
+    // Claim the latest frame, then make sure the producer didn't move on and start re-using it in the meantime
+    do {
+        sequence = latest_sequence;
+        index = latest;
+        reading = index;
+        __dmb();
+    } while (latest != index || latest_sequence != sequence);
+
+    read_sequence = sequence;
+    return &frames[index];
+}
+
+/**
+ * @brief Resets the frame counts. Producer side only.
+ */
+void LedSwapChain::reset_stats() {
+    frames_published = 0;
+    frames_replaced = 0;
+}
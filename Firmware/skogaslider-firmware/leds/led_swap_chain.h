@@ -0,0 +1,53 @@
+/**
+ * @file led_swap_chain.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-14
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "led_layout.h"
+
+/**
+ * @brief A full frame for the LED chain, as GRB words before brightness is applied (the same format as the strip's
+ * pixel buffer).
+ */
+struct LedFrame {
+    uint32_t pixels[NUM_RGB_LEDS];
+};
+
+/**
+ * @brief Hands complete LED frames from a producer on one core to a consumer on the other without locks. There are
+ * three frames: the producer renders into its back frame and publishes it as the latest, and the consumer takes the
+ * latest frame to read from. The producer always picks a back frame that is neither the latest nor the one being
+ * read, so neither side ever waits or sees a half-written frame.
+ *
+ * Each index is only written by one side. The consumer re-checks the latest index after claiming a frame, so a frame
+ * that was re-used by the producer in between is never read.
+ */
+class LedSwapChain {
+    private:
+        LedFrame frames[3];
+        /** Written by the producer only */
+        volatile uint8_t latest;
+        uint8_t back;
+        volatile uint32_t latest_sequence;
+        /** Written by the consumer only */
+        volatile uint8_t reading;
+        volatile uint32_t read_sequence;
+
+    public:
+        /** How many frames the producer has published */
+        uint32_t frames_published;
+        /** How many published frames were replaced by a newer one before the consumer took them, so were never shown */
+        uint32_t frames_replaced;
+
+        LedSwapChain();
+        LedFrame* back_frame();
+        void publish();
+        const LedFrame* take_latest();
+        void reset_stats();
+};
@@ -0,0 +1,211 @@
+/**
+ * @file reactive_lighting.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-12
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include "reactive_lighting.h"
+
+/**
+ * @brief Construct a new ReactiveLighting object
+ * @param swap_chain The swap chain to render frames into
+ * @param frame_period_us How many microseconds to wait between frames
+ */
+ReactiveLighting::ReactiveLighting(LedSwapChain* swap_chain, uint32_t frame_period_us) :
+    swap_chain(swap_chain),
+    frame_period_us(frame_period_us),
+    last_frame_us(time_us_32()),
+    pressed_keys(0),
+    key_flash { 0 },
+    divider_trail { 0 },
+    tower_level(0),
+    tower_flash(0),
+    ripples {},
+    next_ripple(0)
+{
+    render_cycles.reset();
+}
+
+/**
+ * @brief Updates the touch states of the keys, one bit per key, and starts the effects for any newly pressed keys.
+ * This is cheap, so it can be called whenever the touch states change, independent of the frame rate.
+ */
+void ReactiveLighting::set_pressed_keys(uint16_t pressed_keys) {
+    uint16_t new_presses = pressed_keys & ~this->pressed_keys;
+    this->pressed_keys = pressed_keys;
+
+    for (uint8_t key = 0; key < NUM_KEYS; key++) {
+        if (!bit_read(new_presses, key)) {
+            continue;
+        }
+
+        // Sliding onto a key from a neighbour that's still lit leaves a trail on the divider between them
+        if (key > 0 && key_flash[key - 1] > 0) {
+            divider_trail[key - 1] = 255;
+        }
+
+        if (key < NUM_KEYS - 1 && key_flash[key + 1] > 0) {
+            divider_trail[key] = 255;
+        }
+
+        key_flash[key] = 255;
+        tower_flash = 255;
+
+        // Reuse the oldest ripple if they're all in use
+        ripples[next_ripple] = { (uint16_t) ((key * 2) << 8), 0, 255 };
+        next_ripple = (next_ripple + 1) % MAX_RIPPLES;
+    }
+}
+
+/**
+ * @brief Advances the effects and publishes a new frame to the swap chain, if the frame period has passed since
+ * the last frame.
+ * @return true if a frame was rendered
+ */
+bool ReactiveLighting::render_if_due(uint32_t now_us) {
+    if (now_us - last_frame_us < frame_period_us) {
+        return false;
+    }
+
+    last_frame_us = now_us;
+
+    uint32_t start = cycle_counter_read();
+    step();
+    draw(swap_chain->back_frame());
+    swap_chain->publish();
+    render_cycles.record(cycles_since(start));
+
+    return true;
+}
+
+/**
+ * @brief Advances every effect by one frame.
+ */
+void ReactiveLighting::step() {
+    uint8_t pressed_count = 0;
+
+    // Held keys stay fully lit, released keys fade out
+    for (uint8_t key = 0; key < NUM_KEYS; key++) {
+        if (bit_read(pressed_keys, key)) {
+            key_flash[key] = 255;
+            pressed_count++;
+        } else {
+            key_flash[key] = flash_decay[key_flash[key]];
+        }
+    }
+
+    for (uint8_t divider = 0; divider < NUM_DIVIDERS; divider++) {
+        divider_trail[divider] = trail_decay[divider_trail[divider]];
+    }
+
+    for (uint8_t i = 0; i < MAX_RIPPLES; i++) {
+        if (ripples[i].intensity == 0) {
+            continue;
+        }
+
+        ripples[i].radius += RIPPLE_SPEED;
+        ripples[i].intensity = ripple_decay[ripples[i].intensity];
+
+        if (ripples[i].radius > RIPPLE_MAX_RADIUS) {
+            ripples[i].intensity = 0;
+        }
+    }
+
+    // The towers fill up with the number of held keys, rising straight away and falling off slowly
+    uint8_t target_level = pressed_count >= 4 ? 255 : pressed_count * 64;
+
+    if (target_level >= tower_level) {
+        tower_level = target_level;
+    } else {
+        tower_level = tower_decay[tower_level];
+    }
+
+    tower_flash = flash_decay[tower_flash];
+}
+
+/**
+ * @brief Draws the current state of every effect into the given frame.
+ */
+void ReactiveLighting::draw(LedFrame* frame) {
+    const RgbColor key_idle = { KEY_IDLE_COLOR };
+    const RgbColor key_flash_color = { KEY_FLASH_COLOR };
+    const RgbColor divider_idle = { DIVIDER_IDLE_COLOR };
+    const RgbColor divider_ripple = { DIVIDER_RIPPLE_COLOR };
+    const RgbColor tower_idle = { TOWER_IDLE_COLOR };
+    const RgbColor tower_active = { TOWER_ACTIVE_COLOR };
+    const RgbColor tower_flash_color = { TOWER_FLASH_COLOR };
+
+    for (uint8_t key = 0; key < NUM_KEYS; key++) {
+        RgbColor color = blend(key_idle, key_flash_color, key_flash[key]);
+        fill_slot(frame, led_map.keys[key], color);
+    }
+
+    for (uint8_t divider = 0; divider < NUM_DIVIDERS; divider++) {
+        uint16_t amount = ripple_brightness(((divider * 2) + 1) << 8) + divider_trail[divider];
+        RgbColor color = blend(divider_idle, divider_ripple, amount > 255 ? 255 : amount);
+        fill_slot(frame, led_map.dividers[divider], color);
+    }
+
+    // Each tower group lights up in turn from the bottom as the activity level rises
+    for (uint8_t group = 0; group < NUM_TOWER_GROUPS; group++) {
+        int16_t group_level = (tower_level - (group * 85)) * 3;
+        uint8_t amount = group_level < 0 ? 0 : (group_level > 255 ? 255 : group_level);
+        RgbColor color = blend(blend(tower_idle, tower_active, amount), tower_flash_color, tower_flash >> 1);
+
+        for (uint8_t tower = 0; tower < NUM_TOWERS; tower++) {
+            fill_slot(frame, led_map.tower_groups[(tower * NUM_TOWER_GROUPS) + group], color);
+        }
+    }
+}
+
+/**
+ * @brief Adds up how brightly the active ripples light the LED slot at the given position.
+ */
+uint8_t ReactiveLighting::ripple_brightness(uint16_t position) {
+    uint16_t total = 0;
+
+    for (uint8_t i = 0; i < MAX_RIPPLES; i++) {
+        if (ripples[i].intensity == 0) {
+            continue;
+        }
+
+        uint16_t distance = position > ripples[i].position
+            ? position - ripples[i].position
+            : ripples[i].position - position;
+        uint16_t from_edge = distance > ripples[i].radius
+            ? distance - ripples[i].radius
+            : ripples[i].radius - distance;
+
+        if (from_edge < RIPPLE_WIDTH) {
+            total += (ripple_falloff.values[from_edge >> 5] * (ripples[i].intensity + 1)) >> 8;
+        }
+    }
+
+    return total > 255 ? 255 : total;
+}
+
+/**
+ * @brief Blends between two colors, where an amount of 0 is entirely the first color and 255 entirely the second.
+ */
+RgbColor ReactiveLighting::blend(RgbColor from, RgbColor to, uint8_t amount) {
+    // Scale the amount to 0-256, so both ends are exact
+    uint16_t weight = amount + (amount >> 7);
+
+    return {
+        (uint8_t) (from.red + (((to.red - from.red) * weight) >> 8)),
+        (uint8_t) (from.green + (((to.green - from.green) * weight) >> 8)),
+        (uint8_t) (from.blue + (((to.blue - from.blue) * weight) >> 8))
+    };
+}
+
+/**
+ * @brief Writes a color to every LED of the given slot in a frame, as the GRB word the strip expects.
+ */
+void ReactiveLighting::fill_slot(LedFrame* frame, LedSlot slot, RgbColor color) {
+    uint32_t word = (color.green << 24) | (color.red << 16) | (color.blue << 8);
+
+    for (uint8_t i = 0; i < slot.count; i++) {
+        frame->pixels[slot.first + i] = word;
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * @file reactive_lighting.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-12
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+#include "led_controller.h"
+#include "led_swap_chain.h"
+#include "../perf/cycle_counter.h"
+
+/** How many ripples can be spreading across the slider at once, which bounds the render time of a frame */
+#define MAX_RIPPLES 8
+/** How far a ripple spreads each frame, in 1/256ths of an LED slot (keys and dividers are one slot each) */
+#define RIPPLE_SPEED 128
+/** How far from the edge of a ripple a divider is still lit, in 1/256ths of an LED slot */
+#define RIPPLE_WIDTH 512
+/** Ripples that have spread further than this are dropped, in 1/256ths of an LED slot */
+#define RIPPLE_MAX_RADIUS (31 << 8)
+
+/** Per-frame decay factors for the effects, in 1/256ths */
+#define FLASH_DECAY 220
+#define TRAIL_DECAY 235
+#define RIPPLE_DECAY 240
+#define TOWER_DECAY 230
+
+/** Colors used by the effects */
+#define KEY_IDLE_COLOR YELLOW
+#define KEY_FLASH_COLOR BLUE
+#define DIVIDER_IDLE_COLOR PURPLE
+#define DIVIDER_RIPPLE_COLOR 0, 255, 255
+#define TOWER_IDLE_COLOR PURPLE
+#define TOWER_ACTIVE_COLOR BLUE
+#define TOWER_FLASH_COLOR 255, 255, 255
+
+/**
+ * @brief A color as separate 8-bit channels, so the effects can blend colors without going through PicoLed.
+ */
+struct RgbColor {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+};
+
+/**
+ * @brief Precomputed exponential decay, so fading an effect by a constant factor each frame is a table lookup.
+ * Every non-zero value decays by at least one, so effects always reach zero.
+ */
+struct DecayTable {
+    uint8_t values[256];
+
+    constexpr DecayTable(uint16_t factor) : values() {
+        for (uint16_t i = 1; i < 256; i++) {
+            uint16_t decayed = (i * factor) >> 8;
+            values[i] = decayed < i ? decayed : i - 1;
+        }
+    }
+
+    constexpr uint8_t operator[](uint8_t value) const {
+        return values[value];
+    }
+};
+
+/**
+ * @brief Precomputed brightness of a ripple at a given distance from its edge, in 1/32nds of an LED slot. Falls off
+ * quadratically to zero at RIPPLE_WIDTH.
+ */
+struct RippleFalloffTable {
+    static constexpr uint8_t size = RIPPLE_WIDTH >> 5;
+    uint8_t values[size];
+
+    constexpr RippleFalloffTable() : values() {
+        for (uint8_t i = 0; i < size; i++) {
+            uint16_t remaining = size - i;
+            values[i] = (remaining * remaining * 255) / (size * size);
+        }
+    }
+};
+
+/**
+ * @brief A ring spreading outwards from a pressed key. Positions and radii are in 1/256ths of an LED slot, where the
+ * slots alternate between keys and dividers from the left.
+ */
+struct Ripple {
+    uint16_t position;
+    uint16_t radius;
+    uint8_t intensity;
+};
+
+/**
+ * @brief Renders reactive lighting from the touch states, for the modes where the host doesn't drive the LEDs. Each
+ * press flashes its key, sends a ripple out across the dividers, lights a trail on the dividers it slid over, and
+ * makes the air towers react to the overall activity. Everything is integer math and table lookups, rendered at a
+ * fixed frame rate, and the cycles each frame takes to render are recorded. Frames are rendered into a swap chain, so
+ * this can run on a different core from the one sending frames to the LEDs.
+ */
+class ReactiveLighting {
+    private:
+        LedSwapChain* swap_chain;
+        uint32_t frame_period_us;
+        uint32_t last_frame_us;
+        uint16_t pressed_keys;
+
+        uint8_t key_flash[NUM_KEYS];
+        uint8_t divider_trail[NUM_DIVIDERS];
+        uint8_t tower_level;
+        uint8_t tower_flash;
+        Ripple ripples[MAX_RIPPLES];
+        uint8_t next_ripple;
+
+        static constexpr DecayTable flash_decay { FLASH_DECAY };
+        static constexpr DecayTable trail_decay { TRAIL_DECAY };
+        static constexpr DecayTable ripple_decay { RIPPLE_DECAY };
+        static constexpr DecayTable tower_decay { TOWER_DECAY };
+        static constexpr RippleFalloffTable ripple_falloff {};
+
+        void step();
+        void draw(LedFrame* frame);
+        uint8_t ripple_brightness(uint16_t position);
+        static RgbColor blend(RgbColor from, RgbColor to, uint8_t amount);
+        static void fill_slot(LedFrame* frame, LedSlot slot, RgbColor color);
+    public:
+        /** How many cycles it takes to render a frame, and how many frames were rendered */
+        CycleStats render_cycles;
+
+        ReactiveLighting(LedSwapChain* swap_chain, uint32_t frame_period_us);
+        void set_pressed_keys(uint16_t pressed_keys);
+        bool render_if_due(uint32_t now_us);
+};
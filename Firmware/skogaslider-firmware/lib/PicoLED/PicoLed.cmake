@@ -13,4 +13,4 @@ pico_generate_pio_header(PicoLed ${CMAKE_CURRENT_LIST_DIR}/WS2812B.pio)
 target_include_directories(PicoLed INTERFACE ${CMAKE_CURRENT_LIST_DIR})
 
 # Add the standard library to the build
-target_link_libraries(PicoLed INTERFACE pico_stdlib hardware_pio)
\ No newline at end of file
+target_link_libraries(PicoLed INTERFACE pico_stdlib hardware_pio hardware_dma)
\ No newline at end of file
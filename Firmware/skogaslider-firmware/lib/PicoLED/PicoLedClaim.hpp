@@ -0,0 +1,43 @@
+#ifndef PICOLEDCLAIM_H
+#define PICOLEDCLAIM_H
+
+#include "pico/types.h"
+#include "hardware/pio.h"
+
+namespace PicoLed {
+
+// Claims a specific state machine in the SDK's claim registry, which is shared by every strip, static or dynamic, and
+// by anything else using PIO. Returns false if it's already claimed. pio_sm_claim() takes the SDK's claim lock itself,
+// so checking first would leave a race; pio_claim_unused_sm() checks and claims in one step instead, and any free
+// state machines it hands out before the wanted one are given back.
+static inline bool claimStateMachine(PIO pioBlock, uint stateMachine) {
+    uint32_t passedOver = 0;
+    bool claimed = false;
+
+    while (true) {
+        int free = pio_claim_unused_sm(pioBlock, false);
+        if (free < 0 || (uint)free > stateMachine) {
+            // The wanted state machine wasn't free, so give back anything claimed past it too
+            if (free >= 0) {
+                pio_sm_unclaim(pioBlock, free);
+            }
+            break;
+        }
+        if ((uint)free == stateMachine) {
+            claimed = true;
+            break;
+        }
+        passedOver |= 1u << free;
+    }
+
+    for (uint i = 0; passedOver; i++, passedOver >>= 1) {
+        if (passedOver & 1u) {
+            pio_sm_unclaim(pioBlock, i);
+        }
+    }
+    return claimed;
+}
+
+}
+
+#endif
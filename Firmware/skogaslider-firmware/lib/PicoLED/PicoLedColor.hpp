@@ -0,0 +1,81 @@
+#ifndef PICOLEDCOLOR_H
+#define PICOLEDCOLOR_H
+
+#include <algorithm>
+#include "pico/types.h"
+#include "PicoLedTarget.hpp"
+
+// Color helpers and the Q16 fixed-point math used by the *Fixed functions. These don't touch any hardware, so they
+// can be used (and tested) on their own.
+namespace PicoLed {
+
+    static inline Color RGB(uint8_t red, uint8_t green, uint8_t blue) {
+        return (struct Color){ .red = red, .green = green, .blue = blue, .white = std::min(std::min(red, green), blue) };
+    };
+
+    static inline Color RGBW(uint8_t red, uint8_t green, uint8_t blue, uint8_t white) {
+        return (struct Color){ .red = red, .green = green, .blue = blue, .white = white };
+    }
+
+    static inline Color HSV(uint8_t hue, uint8_t saturation, uint8_t value) {
+        if (saturation == 0) {
+            return (struct Color){ .red = value, .green = value, .blue = value, .white = 0 };
+        }
+        uint8_t quadrant = hue / 43;
+        uint8_t remainder = (hue - (quadrant * 43)) * 6;
+        uint8_t p = (value * (255 - saturation)) >> 8;
+        uint8_t q = (value * (255 - ((saturation * remainder) >> 8))) >> 8;
+        uint8_t t = (value * (255 - ((saturation * (255 - remainder)) >> 8))) >> 8;
+        switch (quadrant) {
+            case 0:
+                return (struct Color){ .red = value, .green = t, .blue = p, .white = std::min(t, p) };
+            case 1:
+                return (struct Color){ .red = q, .green = value, .blue = p, .white = std::min(q, p) };
+            case 2:
+                return (struct Color){ .red = p, .green = value, .blue = t, .white = std::min(t, p) };
+            case 3:
+                return (struct Color){ .red = p, .green = q, .blue = value, .white = std::min(q, p) };
+            case 4:
+                return (struct Color){ .red = t, .green = p, .blue = value, .white = std::min(t, p) };
+            default:
+            case 5:
+                return (struct Color){ .red = value, .green = p, .blue = q, .white = std::min(q, p) };
+        }
+    }
+
+    // 1.0 in the Q16 fixed-point format used by the *Fixed functions (ratios, factors and sub-pixel positions)
+    static const uint32_t FIXED_ONE = 1 << 16;
+
+    static inline uint32_t toFixed(double value) {
+        return (uint32_t)(value * FIXED_ONE);
+    }
+
+    static inline uint32_t mulFixed(uint32_t a, uint32_t b) {
+        return (uint32_t)(((uint64_t)a * b) >> 16);
+    }
+
+    static inline Color MixColors(Color colorA, Color colorB, double ratio) {
+        return (struct Color){ 
+            .red = (uint8_t)((double)colorA.red * ratio + (double)colorB.red * (1.0 - ratio)),
+            .green = (uint8_t)((double)colorA.green * ratio + (double)colorB.green * (1.0 - ratio)),
+            .blue = (uint8_t)((double)colorA.blue * ratio + (double)colorB.blue * (1.0 - ratio)),
+            .white = (uint8_t)((double)colorA.white * ratio + (double)colorB.white * (1.0 - ratio)),
+        };
+    }
+
+    static inline Color MixColorsFixed(Color colorA, Color colorB, uint32_t ratio) {
+        // Anything past 1.0 is just colorA, rather than wrapping around
+        if (ratio > FIXED_ONE) {
+            ratio = FIXED_ONE;
+        }
+        uint32_t inverse = FIXED_ONE - ratio;
+        return (struct Color){
+            .red = (uint8_t)((colorA.red * ratio + colorB.red * inverse) >> 16),
+            .green = (uint8_t)((colorA.green * ratio + colorB.green * inverse) >> 16),
+            .blue = (uint8_t)((colorA.blue * ratio + colorB.blue * inverse) >> 16),
+            .white = (uint8_t)((colorA.white * ratio + colorB.white * inverse) >> 16),
+        };
+    }
+}
+
+#endif
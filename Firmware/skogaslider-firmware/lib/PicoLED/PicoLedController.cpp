@@ -1,4 +1,4 @@
-#include "PicoLed.hpp"
+#include "PicoLedColor.hpp"
 #include "PicoLedController.hpp"
 
 using std::min;
@@ -29,6 +29,14 @@ void PicoLedController::setBrightness(uint8_t brightness) {
     target->setBrightness(brightness);
 }
 
+bool PicoLedController::getGammaCorrection() {
+    return target->getGammaCorrection();
+}
+
+void PicoLedController::setGammaCorrection(bool enabled) {
+    target->setGammaCorrection(enabled);
+}
+
 DrawMode PicoLedController::getDrawMode() {
     return mode;
 }
@@ -106,8 +114,8 @@ void PicoLedController::fillGradient(Color colorStart, Color colorEnd, uint firs
         last = target->getNumLeds();
     }
     for (uint i = first; i < last; i++) {
-        double ratio = (double)(i - first) / (double)(last - first);
-        setPixelColor(i, MixColors(colorStart, colorEnd, ratio));
+        uint32_t ratio = ((i - first) * FIXED_ONE) / (last - first);
+        setPixelColor(i, MixColorsFixed(colorStart, colorEnd, ratio));
     }
 }
 
@@ -204,6 +212,114 @@ void PicoLedController::fadePixel(uint index, Color color, double factor) {
     }
 }
 
+void PicoLedController::fadeFixed(Color color, uint32_t factor) {
+    fadeFixed(color, 0, target->getNumLeds(), factor);
+}
+
+void PicoLedController::fadeFixed(Color color, uint first, uint32_t factor) {
+    fadeFixed(color, first, target->getNumLeds() - first, factor);
+}
+
+void PicoLedController::fadeFixed(Color color, uint first, uint count, uint32_t factor) {
+    uint last = first + count;
+    if (last > target->getNumLeds()) {
+        last = target->getNumLeds();
+    }
+    switch (mode) {
+        default:
+        case MODE_SET:
+        {
+            // The share of the new color is the same for every pixel, so only the existing colors need scaling per pixel
+            if (factor > FIXED_ONE) {
+                factor = FIXED_ONE;
+            }
+            uint32_t inverse = FIXED_ONE - factor;
+            uint32_t red = color.red * factor;
+            uint32_t green = color.green * factor;
+            uint32_t blue = color.blue * factor;
+            uint32_t white = color.white * factor;
+            for (uint i = first; i < last; i++) {
+                Color pixelColor = target->getPixelColor(i);
+                pixelColor.red = (red + pixelColor.red * inverse) >> 16;
+                pixelColor.green = (green + pixelColor.green * inverse) >> 16;
+                pixelColor.blue = (blue + pixelColor.blue * inverse) >> 16;
+                pixelColor.white = (white + pixelColor.white * inverse) >> 16;
+                target->setPixelColor(i, pixelColor);
+            }
+            break;
+        }
+        case MODE_ADD:
+        case MODE_SUB:
+        {
+            // Adding or subtracting the same faded color everywhere
+            Color faded = MixColorsFixed(color, RGB(0, 0, 0), factor);
+            for (uint i = first; i < last; i++) {
+                setPixelColor(i, faded);
+            }
+            break;
+        }
+    }
+}
+
+void PicoLedController::fadeLineFixed(Color color, int32_t first, uint32_t factor) {
+    fadeLineFixed(color, first, (int32_t)(target->getNumLeds() * FIXED_ONE) - first, factor);
+}
+
+void PicoLedController::fadeLineFixed(Color color, int32_t first, int32_t count, uint32_t factor) {
+    int32_t numLeds = target->getNumLeds() * FIXED_ONE;
+    if (first < 0) {
+        // Clamp to start
+        count += first;
+        first = 0;
+    }
+    if ((first + count) > numLeds) {
+        // Clamp to end
+        count = numLeds - first;
+    }
+    if (count <= 0) {
+        // Out of bounds / zero length
+        return;
+    }
+    int32_t last = first + count;
+    int32_t middleStart = (first + FIXED_ONE - 1) & ~(FIXED_ONE - 1);
+    if (last <= middleStart) {
+        // Single pixel
+        fadePixelFixed(first >> 16, color, mulFixed(last - first, factor));
+    } else {
+        int32_t middleEnd = last & ~(FIXED_ONE - 1);
+        // First pixel
+        if (middleStart > first) {
+            fadePixelFixed(first >> 16, color, mulFixed(middleStart - first, factor));
+        }
+        // Middle section
+        if (middleEnd - middleStart >= (int32_t)FIXED_ONE) {
+            fadeFixed(color, middleStart >> 16, (middleEnd - middleStart) >> 16, factor);
+        }
+        // Last pixel
+        if (last > middleEnd) {
+            fadePixelFixed(middleEnd >> 16, color, mulFixed(last - middleEnd, factor));
+        }
+    }
+}
+
+void PicoLedController::fadePixelFixed(uint index, Color color, uint32_t factor) {
+    switch (mode) {
+        default:
+        case MODE_SET:
+        {
+            Color pixelColor = target->getPixelColor(index);
+            setPixelColor(index, MixColorsFixed(color, pixelColor, factor));
+            break;
+        }
+        case MODE_ADD:
+        case MODE_SUB:
+        {
+            setPixelColor(index, MixColorsFixed(color, RGB(0, 0, 0), factor));
+            break;
+        }
+    }
+}
+
 void PicoLedController::fadeValue(Color color, uint8_t value) {
     fadeValue(color, 0, target->getNumLeds(), value);
 }
@@ -259,6 +375,30 @@ void PicoLedController::fadePixelValue(uint index, Color color, uint8_t value) {
     setPixelColor(index, pixelColor, MODE_SET);
 }
 
+uint32_t* PicoLedController::getBuffer() {
+    return target->getBuffer();
+}
+
+void PicoLedController::bufferChanged(uint first, uint count) {
+    target->bufferChanged(first, count);
+}
+
+uint32_t PicoLedController::getOutputLevel() {
+    return target->getOutputLevel();
+}
+
+uint32_t PicoLedController::getFramesShown() {
+    return target->getFramesShown();
+}
+
+uint32_t PicoLedController::getFramesSuppressed() {
+    return target->getFramesSuppressed();
+}
+
+void PicoLedController::resetFrameCounts() {
+    target->resetFrameCounts();
+}
+
 void PicoLedController::show() {
     target->show();
 }
@@ -5,7 +5,6 @@
 #include <algorithm>
 #include <memory>
 #include "pico/types.h"
-#include "hardware/pio.h"
 #include "PicoLedTarget.hpp"
 
 using std::shared_ptr;
@@ -28,11 +27,19 @@ class PicoLedController {
         uint getNumLeds();
         uint8_t getBrightness();
         void setBrightness(uint8_t brightness);
+        bool getGammaCorrection();
+        void setGammaCorrection(bool enabled);
         DrawMode getDrawMode();
         void setDrawMode(DrawMode mode);
         Color getPixelColor(uint index);
         void setPixelColor(uint index, Color color);
         void setPixelColor(uint index, Color color, DrawMode mode);
+        uint32_t* getBuffer();
+        void bufferChanged(uint first, uint count);
+        uint32_t getOutputLevel();
+        uint32_t getFramesShown();
+        uint32_t getFramesSuppressed();
+        void resetFrameCounts();
         void show();
         void clear();
         void clear(Color color);
@@ -51,6 +58,12 @@ class PicoLedController {
         void fadeLine(Color color, double first, double factor);
         void fadeLine(Color color, double first, double count, double factor);
         void fadePixel(uint index, Color color, double factor);
+        void fadeFixed(Color color, uint32_t factor);
+        void fadeFixed(Color color, uint first, uint32_t factor);
+        void fadeFixed(Color color, uint first, uint count, uint32_t factor);
+        void fadeLineFixed(Color color, int32_t first, uint32_t factor);
+        void fadeLineFixed(Color color, int32_t first, int32_t count, uint32_t factor);
+        void fadePixelFixed(uint index, Color color, uint32_t factor);
         void fadeValue(Color color, uint8_t value);
         void fadeValue(Color color, uint first, uint8_t value);
         void fadeValue(Color color, uint first, uint count, uint8_t value);
@@ -0,0 +1,114 @@
+#ifndef PICOLEDGAMMA_H
+#define PICOLEDGAMMA_H
+
+#include "pico/types.h"
+
+namespace PicoLed {
+
+// Exponent of the gamma curve applied to colors before they are sent to the LEDs
+#ifndef PICOLED_GAMMA
+#define PICOLED_GAMMA 2.6
+#endif
+
+namespace Gamma {
+
+    constexpr double LN2 = 0.69314718055994530942;
+
+    // Natural logarithm for x > 0, reduced to a mantissa in [0.5, 1) and evaluated with the atanh series
+    constexpr double log(double x) {
+        int exponent = 0;
+        while (x >= 1.0) {
+            x /= 2.0;
+            exponent++;
+        }
+        while (x < 0.5) {
+            x *= 2.0;
+            exponent--;
+        }
+        double z = (x - 1.0) / (x + 1.0);
+        double zSquared = z * z;
+        double term = z;
+        double sum = 0.0;
+        for (int n = 1; n < 40; n += 2) {
+            sum += term / n;
+            term *= zSquared;
+        }
+        return 2.0 * sum + exponent * LN2;
+    }
+
+    // Exponential function, reduced to a remainder in [0, ln 2) and evaluated with the Taylor series
+    constexpr double exp(double x) {
+        int exponent = 0;
+        while (x >= LN2) {
+            x -= LN2;
+            exponent++;
+        }
+        while (x < 0.0) {
+            x += LN2;
+            exponent--;
+        }
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 20; n++) {
+            term *= x / n;
+            sum += term;
+        }
+        for (; exponent > 0; exponent--) {
+            sum *= 2.0;
+        }
+        for (; exponent < 0; exponent++) {
+            sum /= 2.0;
+        }
+        return sum;
+    }
+
+    constexpr uint8_t correct(uint8_t value, double gamma) {
+        if (value == 0) {
+            return 0;
+        }
+        return (uint8_t)(exp(gamma * log(value / 255.0)) * 255.0 + 0.5);
+    }
+
+    struct Table {
+        uint8_t values[256];
+
+        constexpr Table(double gamma) : values() {
+            for (uint i = 0; i < 256; i++) {
+                values[i] = correct(i, gamma);
+            }
+        }
+
+        constexpr uint8_t operator[](uint index) const {
+            return values[index];
+        }
+    };
+
+    // Gamma corrected value for every 8-bit channel value, generated at compile time
+    constexpr Table table(PICOLED_GAMMA);
+
+    static_assert(table[0] == 0 && table[255] == 255, "Gamma table has to keep black and full intensity");
+    static_assert(table[128] < 128, "Gamma table has to darken the mid-tones");
+}
+
+// Brightness and gamma folded into one table, so scaling a pixel for the wire is a single lookup per byte whether
+// gamma correction is on or not. Only rebuilt when the brightness or gamma setting changes.
+struct ScaleTable {
+    uint8_t values[256];
+
+    void update(uint8_t brightness, bool gammaCorrection) {
+        for (uint i = 0; i < 256; i++) {
+            values[i] = gammaCorrection ? (Gamma::table[i] * brightness + 127) / 255 : (i * brightness) >> 8;
+        }
+    }
+
+    uint32_t scale(uint32_t value) const {
+        return (values[value >> 24] << 24)
+            | (values[(value >> 16) & 0xFF] << 16)
+            | (values[(value >> 8) & 0xFF] << 8)
+            | values[value & 0xFF];
+    }
+};
+
+}
+
+#endif
@@ -1,4 +1,4 @@
-#include "PicoLed.hpp"
+#include "PicoLedColor.hpp"
 #include "PicoLedTarget.hpp"
 #include <stdio.h>
 
@@ -6,12 +6,20 @@ using std::min;
 
 namespace PicoLed {
 
-PicoLedTarget::PicoLedTarget(uint numLeds, DataByte b1, DataByte b2, DataByte b3, DataByte b4): numLeds(numLeds), brightness(255)
+PicoLedTarget::PicoLedTarget(uint numLeds, DataByte b1, DataByte b2, DataByte b3, DataByte b4): numLeds(numLeds), brightness(255), gammaCorrection(false), framesShown(0), framesSuppressed(0)
 {
     bytes[0] = b1;
     bytes[1] = b2;
     bytes[2] = b3;
     bytes[3] = b4;
+
+    // Multiplying a channel by its scale moves it to its byte in the pixel data (or drops it, if the format hasn't got it)
+    for (uint c = 0; c < 5; c++) {
+        channelScale[c] = 0;
+    }
+    for (uint b = 0; b < 4; b++) {
+        channelScale[bytes[b]] = 1 << (8 * (3 - b));
+    }
 }
 
 PicoLedTarget::~PicoLedTarget() {
@@ -29,6 +37,37 @@ void PicoLedTarget::setBrightness(uint8_t brightness) {
     this->brightness = brightness;
 }
 
+bool PicoLedTarget::getGammaCorrection() {
+    return gammaCorrection;
+}
+
+void PicoLedTarget::setGammaCorrection(bool enabled) {
+    gammaCorrection = enabled;
+}
+
+uint32_t PicoLedTarget::getOutputLevel() {
+    // Targets without an output buffer approximate it from the pixels and the brightness (without gamma)
+    uint32_t level = 0;
+    for (uint i = 0; i < numLeds; i++) {
+        uint32_t value = getData(i);
+        level += (value >> 24) + ((value >> 16) & 0xFF) + ((value >> 8) & 0xFF) + (value & 0xFF);
+    }
+    return (level * brightness) / 255;
+}
+
+uint32_t PicoLedTarget::getFramesShown() {
+    return framesShown;
+}
+
+uint32_t PicoLedTarget::getFramesSuppressed() {
+    return framesSuppressed;
+}
+
+void PicoLedTarget::resetFrameCounts() {
+    framesShown = 0;
+    framesSuppressed = 0;
+}
+
 Color PicoLedTarget::getPixelColor(uint index) {
     Color pixelColor = RGBW(0, 0, 0, 0);
     uint32_t pixelData = getData(index);
@@ -68,25 +107,10 @@ void PicoLedTarget::fill(Color color, uint first, uint count) {
 }
 
 uint32_t PicoLedTarget::getPixelData(Color color) {
-    uint32_t result = 0;
-    for (uint b = 0; b < 4; b++) {
-        result <<= 8;
-        switch (bytes[b]) {
-            case RED:
-                result |= color.red;
-                break;
-            case GREEN:
-                result |= color.green;
-                break;
-            case BLUE:
-                result |= color.blue;
-                break;
-            case WHITE:
-                result |= color.white;
-                break;
-        }
-    }
-    return result;
+    return color.red * channelScale[RED]
+        + color.green * channelScale[GREEN]
+        + color.blue * channelScale[BLUE]
+        + color.white * channelScale[WHITE];
 }
 
 uint32_t PicoLedTarget::scalePixelData(uint32_t data, uint16_t scale) {
@@ -102,6 +126,13 @@ uint32_t PicoLedTarget::getData(uint index) {
 void PicoLedTarget::setData(uint index, uint32_t value) {
 }
 
+uint32_t* PicoLedTarget::getBuffer() {
+    return NULL;
+}
+
+void PicoLedTarget::bufferChanged(uint first, uint count) {
+}
+
 void PicoLedTarget::show() {
 }
 
@@ -34,9 +34,17 @@ class PicoLedTarget {
         virtual uint getNumLeds();
         virtual uint8_t getBrightness();
         virtual void setBrightness(uint8_t brightness);
+        virtual bool getGammaCorrection();
+        virtual void setGammaCorrection(bool enabled);
         virtual uint32_t getData(uint index);
         virtual void setData(uint index, uint32_t value);
+        virtual uint32_t* getBuffer();
+        virtual void bufferChanged(uint first, uint count);
+        virtual uint32_t getOutputLevel();
         virtual void show();
+        uint32_t getFramesShown();
+        uint32_t getFramesSuppressed();
+        void resetFrameCounts();
         Color getPixelColor(uint index);
         void setPixelColor(uint index, Color color);
         void fill(Color color, uint first, uint count);
@@ -46,7 +54,11 @@ class PicoLedTarget {
 
         uint numLeds;
         DataByte bytes[4];
+        uint32_t channelScale[5];
         uint8_t brightness;
+        bool gammaCorrection;
+        uint32_t framesShown;
+        uint32_t framesSuppressed;
 };
 
 };
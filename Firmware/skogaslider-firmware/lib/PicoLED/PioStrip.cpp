@@ -1,20 +1,72 @@
 #include "PicoLed.hpp"
 #include "PioStrip.hpp"
+#include "PicoLedGamma.hpp"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include <stdio.h>
+#include <string.h>
 
 namespace PicoLed {
 
+PioStrip *PioStrip::dmaStrips[NUM_DMA_CHANNELS];
+bool PioStrip::dmaIrqInstalled = false;
+
 PioStrip::PioStrip(
     PIO pioBlock, uint stateMachine, uint dataPin, uint numLeds, DataByte b1, DataByte b2, DataByte b3, DataByte b4
 ):
-PicoLedTarget(numLeds, b1, b2, b3, b4), pioBlock(pioBlock), stateMachine(stateMachine), dataPin(dataPin)
+PicoLedTarget(numLeds, b1, b2, b3, b4), pioBlock(pioBlock), stateMachine(stateMachine), dataPin(dataPin),
+outputLevel(0), latchAlarmId(0), activeFrame(0), busy(false), pending(false), dirty(true)
 {
+    updateScaleTable();
+
     data = new uint32_t[numLeds];
+    wire = new uint32_t[numLeds]();
+    frames[0] = new uint32_t[numLeds];
+    frames[1] = new uint32_t[numLeds];
     fill(RGB(0, 0, 0), 0, numLeds);
+
+    // When the DMA finishes, the joined TX FIFO (8 words) and the output shift register still have to be
+    // shifted out before the line goes low, so wait for those on top of the reset time before latching
+    uint bitsPerLed = (b4 == NONE ? 24 : 32);
+    latchDelayUs = (9 * bitsPerLed * PIOSTRIP_BIT_NS) / 1000 + PIOSTRIP_RESET_US;
+
+    // Stream 32-bit pixels into the TX FIFO of the state machine, paced by its DREQ
+    dmaChannel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, pio_get_dreq(pioBlock, stateMachine, true));
+    dma_channel_configure(dmaChannel, &config, &pioBlock->txf[stateMachine], frames[0], numLeds, false);
+
+    // All strips share a single handler on DMA_IRQ_0, which looks up the strip by channel
+    dmaStrips[dmaChannel] = this;
+    if (!dmaIrqInstalled) {
+        irq_add_shared_handler(DMA_IRQ_0, dmaIrqHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        dmaIrqInstalled = true;
+    }
+    dma_channel_set_irq0_enabled(dmaChannel, true);
 }
 
 PioStrip::~PioStrip() {
-    delete data;
+    dma_channel_set_irq0_enabled(dmaChannel, false);
+
+    // A frame that's latching still has an alarm pointing at this strip, which mustn't fire once it's gone
+    uint32_t irqStatus = save_and_disable_interrupts();
+    if (latchAlarmId > 0) {
+        cancel_alarm(latchAlarmId);
+        latchAlarmId = 0;
+    }
+    restore_interrupts(irqStatus);
+
+    dma_channel_abort(dmaChannel);
+    dma_channel_unclaim(dmaChannel);
+    dmaStrips[dmaChannel] = NULL;
+    delete[] data;
+    delete[] wire;
+    delete[] frames[0];
+    delete[] frames[1];
 }
 
 uint32_t PioStrip::getData(uint index) {
@@ -23,12 +75,143 @@ uint32_t PioStrip::getData(uint index) {
 
 void PioStrip::setData(uint index, uint32_t value) {
     data[index] = value;
+    updateWireData(index);
+}
+
+uint32_t* PioStrip::getBuffer() {
+    return data;
+}
+
+void PioStrip::bufferChanged(uint first, uint count) {
+    uint last = (first + count);
+    if (last > numLeds) {
+        last = numLeds;
+    }
+    for (uint i = first; i < last; i++) {
+        updateWireData(i);
+    }
+}
+
+void PioStrip::setBrightness(uint8_t brightness) {
+    if (brightness == this->brightness) {
+        return;
+    }
+    this->brightness = brightness;
+    updateScaleTable();
+    bufferChanged(0, numLeds);
+}
+
+void PioStrip::setGammaCorrection(bool enabled) {
+    if (enabled == gammaCorrection) {
+        return;
+    }
+    gammaCorrection = enabled;
+    updateScaleTable();
+    bufferChanged(0, numLeds);
+}
+
+void PioStrip::updateScaleTable() {
+    scaleTable.update(brightness, gammaCorrection);
+}
+
+void PioStrip::updateWireData(uint index) {
+    // Only flag the frame for sending if what goes out on the wire actually changes
+    uint32_t value = scaleWireData(data[index]);
+    if (wire[index] != value) {
+        // Keep the output level current as pixels change, so reading it never has to go over the whole strip
+        outputLevel += sumChannels(value) - sumChannels(wire[index]);
+        wire[index] = value;
+        dirty = true;
+    }
+}
+
+uint32_t PioStrip::scaleWireData(uint32_t value) {
+    return scaleTable.scale(value);
+}
+
+uint32_t PioStrip::sumChannels(uint32_t value) {
+    // Adds the bytes two at a time, in the even and odd bytes of the word
+    uint32_t pairs = (value & 0x00FF00FF) + ((value >> 8) & 0x00FF00FF);
+    return (pairs & 0xFFFF) + (pairs >> 16);
+}
+
+uint32_t PioStrip::getOutputLevel() {
+    return outputLevel;
+}
+
+bool PioStrip::isBusy() {
+    return busy;
 }
 
 void PioStrip::show() {
-    for (uint i = 0; i < numLeds; i++) {
-        pio_sm_put_blocking(pioBlock, stateMachine, scalePixelData(data[i], brightness));
+    // Nothing to do if the LEDs already show the current pixels
+    if (!dirty) {
+        framesSuppressed++;
+        return;
+    }
+    dirty = false;
+    framesShown++;
+
+    // Take back any frame still waiting for the current transfer, so it can't be started while it's rewritten
+    uint32_t irqStatus = save_and_disable_interrupts();
+    pending = false;
+    uint frame = activeFrame ^ 1;
+    restore_interrupts(irqStatus);
+
+    // The wire buffer is already scaled and in the order the state machine shifts it out
+    memcpy(frames[frame], wire, numLeds * sizeof(uint32_t));
+
+    // Start right away if the strip is idle, otherwise queue the frame until the current one has latched
+    irqStatus = save_and_disable_interrupts();
+    if (busy) {
+        pending = true;
+    } else {
+        startTransfer(frame);
+    }
+    restore_interrupts(irqStatus);
+}
+
+void PioStrip::startTransfer(uint frame) {
+    activeFrame = frame;
+    busy = true;
+    dma_channel_transfer_from_buffer_now(dmaChannel, frames[frame], numLeds);
+}
+
+void PioStrip::onTransferDone() {
+    // A negative id means no alarm could be set (e.g. the alarm pool is full). Rather than leave the strip busy
+    // forever, wait out the latch time here instead. (An id of 0 means the alarm already fired.)
+    alarm_id_t id = add_alarm_in_us(latchDelayUs, latchAlarm, this, true);
+    if (id < 0) {
+        busy_wait_us_32(latchDelayUs);
+        onLatched();
+    } else if (id > 0) {
+        latchAlarmId = id;
+    }
+}
+
+void PioStrip::onLatched() {
+    if (pending) {
+        pending = false;
+        startTransfer(activeFrame ^ 1);
+    } else {
+        busy = false;
     }
 }
 
-}
\ No newline at end of file
+void PioStrip::dmaIrqHandler() {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (dmaStrips[channel] != NULL && dma_channel_get_irq0_status(channel)) {
+            dma_channel_acknowledge_irq0(channel);
+            dmaStrips[channel]->onTransferDone();
+        }
+    }
+}
+
+int64_t PioStrip::latchAlarm(alarm_id_t id, void *userData) {
+    PioStrip *strip = (PioStrip*) userData;
+    strip->latchAlarmId = 0;
+    strip->onLatched();
+    return 0;
+}
+
+}
@@ -2,10 +2,19 @@
 #define PIOSTRIP_H
 
 #include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "pico/time.h"
 #include "PicoLedTarget.hpp"
+#include "PicoLedGamma.hpp"
 
 namespace PicoLed {
 
+// Time the data line has to be held low for the LEDs to latch a frame (datasheet minimum is 50us, newer parts need more)
+#define PIOSTRIP_RESET_US 80
+
+// Time the PIO takes to shift out a single bit (800kHz)
+#define PIOSTRIP_BIT_NS 1250
+
 class PioStrip: public PicoLedTarget {
     public:
         PioStrip(PIO pioBlock, uint stateMachine, uint dataPin, uint numLeds, DataByte b1, DataByte b2, DataByte b3, DataByte b4);
@@ -13,14 +22,47 @@ class PioStrip: public PicoLedTarget {
 
         uint32_t getData(uint index);
         void setData(uint index, uint32_t value);
+        uint32_t* getBuffer();
+        void bufferChanged(uint first, uint count);
+        void setBrightness(uint8_t brightness);
+        void setGammaCorrection(bool enabled);
+        uint32_t getOutputLevel();
         void show();
+        bool isBusy();
     protected:
+        void updateScaleTable();
+        void updateWireData(uint index);
+        uint32_t scaleWireData(uint32_t value);
+        static uint32_t sumChannels(uint32_t value);
+
         PIO pioBlock;
         uint stateMachine;
         uint dataPin;
         uint32_t *data;
+        uint32_t *wire;
+        ScaleTable scaleTable;
+        uint32_t outputLevel;
+    private:
+        void startTransfer(uint frame);
+        void onTransferDone();
+        void onLatched();
+        static void dmaIrqHandler();
+        static int64_t latchAlarm(alarm_id_t id, void *userData);
+
+        static PioStrip *dmaStrips[NUM_DMA_CHANNELS];
+        static bool dmaIrqInstalled;
+
+        uint dmaChannel;
+        uint32_t latchDelayUs;
+        // The alarm waiting for the current frame to latch, or 0 if there isn't one
+        volatile alarm_id_t latchAlarmId;
+        uint32_t *frames[2];
+        volatile uint activeFrame;
+        volatile bool busy;
+        volatile bool pending;
+        volatile bool dirty;
 };
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,193 @@
+#ifndef STATICPIOSTRIP_H
+#define STATICPIOSTRIP_H
+
+#include <string.h>
+#include "pico/types.h"
+#include "pico/time.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "PicoLedTarget.hpp"
+#include "PicoLedClaim.hpp"
+#include "PicoLedGamma.hpp"
+#include "PioStrip.hpp"
+#include "WS2812B.pio.h"
+
+namespace PicoLed {
+
+// Where each channel goes in the pixel data for a format, as the bit shift of its byte (or -1 if it has none)
+constexpr int formatShift(DataFormat format, DataByte channel) {
+    switch (format) {
+        case FORMAT_RGB:
+            return channel == RED ? 24 : channel == GREEN ? 16 : channel == BLUE ? 8 : -1;
+        case FORMAT_WRGB:
+            return channel == RED ? 24 : channel == GREEN ? 16 : channel == BLUE ? 8 : 0;
+        case FORMAT_GRB:
+        default:
+            return channel == GREEN ? 24 : channel == RED ? 16 : channel == BLUE ? 8 : -1;
+    }
+}
+
+/**
+ * A WS2812B strip with its size and byte order fixed at compile time. All pixel storage is part of the object, so
+ * declaring it as a global needs no heap, and pixel access is inlined without any virtual calls. Errors are reported
+ * through return values instead of exceptions.
+ */
+template<uint NumLeds, DataFormat Format>
+class StaticPioStrip {
+    public:
+        static constexpr uint numLeds = NumLeds;
+        static constexpr uint bitsPerLed = (Format == FORMAT_WRGB ? 32 : 24);
+
+        StaticPioStrip(): pioBlock(NULL), stateMachine(0), dmaChannel(-1), brightness(255), gammaCorrection(false),
+            readyUs(0), dirty(true), data(), wire(), frame()
+        {
+            updateScaleTable();
+        }
+
+        // Claims the state machine and a DMA channel and starts the strip. Returns false if either is already in use.
+        bool begin(PIO pioBlock, uint stateMachine, uint dataPin) {
+            if (!claimStateMachine(pioBlock, stateMachine)) {
+                return false;
+            }
+            dmaChannel = dma_claim_unused_channel(false);
+            if (dmaChannel < 0) {
+                pio_sm_unclaim(pioBlock, stateMachine);
+                return false;
+            }
+            this->pioBlock = pioBlock;
+            this->stateMachine = stateMachine;
+
+            uint offset = pio_add_program(pioBlock, &WS2812B_program);
+            WS2812B_program_init(pioBlock, stateMachine, offset, dataPin, 800000, bitsPerLed);
+
+            dma_channel_config config = dma_channel_get_default_config(dmaChannel);
+            channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+            channel_config_set_read_increment(&config, true);
+            channel_config_set_write_increment(&config, false);
+            channel_config_set_dreq(&config, pio_get_dreq(pioBlock, stateMachine, true));
+            dma_channel_configure(dmaChannel, &config, &pioBlock->txf[stateMachine], frame, NumLeds, false);
+            return true;
+        }
+
+        uint8_t getBrightness() {
+            return brightness;
+        }
+
+        void setBrightness(uint8_t brightness) {
+            if (brightness != this->brightness) {
+                this->brightness = brightness;
+                updateScaleTable();
+                rescale(0, NumLeds);
+            }
+        }
+
+        bool getGammaCorrection() {
+            return gammaCorrection;
+        }
+
+        void setGammaCorrection(bool enabled) {
+            if (enabled != gammaCorrection) {
+                gammaCorrection = enabled;
+                updateScaleTable();
+                rescale(0, NumLeds);
+            }
+        }
+
+        static constexpr uint32_t packColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t white = 0) {
+            return ((uint32_t)red << formatShift(Format, RED))
+                | ((uint32_t)green << formatShift(Format, GREEN))
+                | ((uint32_t)blue << formatShift(Format, BLUE))
+                | (formatShift(Format, WHITE) < 0 ? 0 : (uint32_t)white << formatShift(Format, WHITE));
+        }
+
+        uint32_t getData(uint index) {
+            return data[index];
+        }
+
+        void setData(uint index, uint32_t value) {
+            data[index] = value;
+            rescale(index, 1);
+        }
+
+        void setPixelColor(uint index, Color color) {
+            setData(index, packColor(color.red, color.green, color.blue, color.white));
+        }
+
+        Color getPixelColor(uint index) {
+            uint32_t value = data[index];
+            return (struct Color){
+                .red = (uint8_t)(value >> formatShift(Format, RED)),
+                .green = (uint8_t)(value >> formatShift(Format, GREEN)),
+                .blue = (uint8_t)(value >> formatShift(Format, BLUE)),
+                .white = (uint8_t)(formatShift(Format, WHITE) < 0 ? 0 : value >> formatShift(Format, WHITE))
+            };
+        }
+
+        void fill(Color color, uint first, uint count) {
+            uint32_t value = packColor(color.red, color.green, color.blue, color.white);
+            uint last = (first + count > NumLeds ? NumLeds : first + count);
+            for (uint i = first; i < last; i++) {
+                data[i] = value;
+            }
+            rescale(first, last - first);
+        }
+
+        // Raw pixel data, for writing many pixels at once. Call bufferChanged() for the range afterwards.
+        uint32_t* getBuffer() {
+            return data;
+        }
+
+        void bufferChanged(uint first, uint count) {
+            rescale(first, count);
+        }
+
+        // Starts sending the current pixels by DMA, unless nothing changed since the last frame. Returns false if the
+        // previous frame is still being sent or latched, in which case show() has to be called again later.
+        bool show() {
+            if (!dirty) {
+                return true;
+            }
+            if (pioBlock == NULL || dma_channel_is_busy(dmaChannel) || (int32_t)(time_us_32() - readyUs) < 0) {
+                return false;
+            }
+            dirty = false;
+            memcpy(frame, wire, sizeof(frame));
+            dma_channel_transfer_from_buffer_now(dmaChannel, frame, NumLeds);
+
+            // Ready once all the bits, plus the reset time, have gone out
+            readyUs = time_us_32() + (NumLeds * bitsPerLed * PIOSTRIP_BIT_NS) / 1000 + PIOSTRIP_RESET_US;
+            return true;
+        }
+
+    private:
+        void updateScaleTable() {
+            scaleTable.update(brightness, gammaCorrection);
+        }
+
+        void rescale(uint first, uint count) {
+            uint last = (first + count > NumLeds ? NumLeds : first + count);
+            for (uint i = first; i < last; i++) {
+                uint32_t scaled = scaleTable.scale(data[i]);
+                if (wire[i] != scaled) {
+                    wire[i] = scaled;
+                    dirty = true;
+                }
+            }
+        }
+
+        PIO pioBlock;
+        uint stateMachine;
+        int dmaChannel;
+        uint8_t brightness;
+        bool gammaCorrection;
+        uint32_t readyUs;
+        bool dirty;
+        ScaleTable scaleTable;
+        uint32_t data[NumLeds];
+        uint32_t wire[NumLeds];
+        uint32_t frame[NumLeds];
+};
+
+};
+
+#endif
@@ -12,58 +12,196 @@
 #include "pico/multicore.h"
 
 #include "config.h"
+#include "air/air_sensor.h"
+#include "buttons/buttons.h"
+#include "mode/mode_selector.h"
+#include "sega_hardware/io4/sega_io4.h"
 #include "sega_hardware/led_board/sega_led_board.h"
 #include "sega_hardware/serial/sega_serial_reader.h"
 #include "sega_hardware/slider/sega_slider.h"
+#include "sega_hardware/slider/slider_report_scheduler.h"
 #include "leds/led_controller.h"
+#include "leds/reactive_lighting.h"
+#include "perf/interp_kernels.h"
+#include "perf/led_math_benchmark.h"
+#include "perf/led_strip_benchmark.h"
 #include "slider/touch_slider.h"
 #include "tinyusb/usb_descriptors.h"
 #include "usb_output/usb_output.h"
 
-/** 
- * This divisor is used for limiting the lights output rate, by dividing the USB output rate (1000Hz) by this divisor and tying
- * the lights output to the USB output, if a counter reaches (LIGHTS_UPDATE_DIVISOR - 1). This effectively divides 1000 by 
- * LIGHTS_UPDATE_DIVISOR and this is the update rate of the lights.
+/**
+ * How many microseconds to wait between LED frames. Changes from the slider, LED boards and reactive lighting are
+ * collected and sent to the LEDs together, at most once per period.
+ */
+#define LED_FRAME_PERIOD_US 4000
+
+/**
+ * The longest a change to the LEDs may wait to be sent, in microseconds, even if the frame period hasn't passed yet.
+ * Set this to 0 to only commit frames on the frame period.
+ */
+#define LED_MAX_LATENCY_US 0
+
+/**
+ * How many microseconds the LEDs take to blend from one host LED frame to the next in AC-mode, to smooth out the
+ * steps between the game's roughly 60Hz LED updates (16000 blends over about one host frame). Channels that jump up
+ * by a lot, like hit flashes, still change instantly. Set this to 0 to show host frames as they arrive.
  */
-#define LIGHTS_UPDATE_DIVISOR 4
+#define LED_INTERPOLATION_US 0
+
+/**
+ * How many microseconds to wait in AC-mode between slider reports. This can be anywhere from 1000 (one report per
+ * USB frame) up to SLIDER_REPORT_PERIOD_MAX_US, to match the timing of a real slider.
+ */
+#define SLIDER_REPORT_PERIOD_US 4000
+
+/**
+ * Uncomment this to only send slider reports in AC-mode when the touch states change (at most once per USB frame),
+ * instead of every SLIDER_REPORT_PERIOD_US. Between changes, a heartbeat report is sent every SLIDER_HEARTBEAT_US
+ * so the game doesn't decide the slider has disconnected.
+ */
+// #define SLIDER_REPORT_ON_CHANGE
+
+/** How many microseconds to wait between heartbeat slider reports when reporting on change */
+#define SLIDER_HEARTBEAT_US 50000
 
-/** How many milliseconds to wait in AC-mode between slider reports */
-#define SLIDER_REPORT_DELAY 4
+/** How many microseconds to wait between frames of the reactive lighting effects in keyboard mode */
+#define REACTIVE_FRAME_PERIOD_US 8000
 
 /** How many milliseconds to wait between logging input and output rates */
 #define LOG_DELAY 1000
 
+/**
+ * Uncomment this to time the hardware interpolator kernels against their plain C versions once per log interval,
+ * to check on the board that they're actually faster.
+ */
+// #define BENCHMARK_INTERP_KERNELS
+
+/**
+ * Uncomment this to time PicoLed's double color math against the fixed-point versions once per log interval, for a
+ * 65-LED gradient and fade, and the linear pixel scaling against the combined brightness and gamma table.
+ */
+// #define BENCHMARK_LED_MATH
+
+/**
+ * Uncomment this to time pixel writes on the fixed-size StaticPioStrip against the strip driving the LEDs once per log
+ * interval, and print how much RAM each takes. The flash each costs can be compared with arm-none-eabi-size on builds
+ * with and without this.
+ */
+// #define BENCHMARK_STATIC_STRIP
+
 /** How many milliseconds since the last serial packet to wait before disabling auto-touch reports */
 #define AC_SLIDER_TIMEOUT 5000
 
 /**
- * Uncomment this if you want to use keyboard output and reactive lights, instead of the arcade slider protocol. This will eventually
- * be driven by a button press at runtime or something, but arcade protocol is the default behavior for now.
+ * The output mode to use until another one is picked: OUTPUT_MODE_ARCADE for the arcade slider, LED board and IO4
+ * protocols, or OUTPUT_MODE_KEYBOARD for keyboard output and reactive lights. Holding the function button while
+ * plugging in the controller, or for MODE_SWITCH_HOLD_US while it's running, switches to the other mode, and the mode
+ * picked is kept in flash.
  */
-// #define USE_KEYBOARD_OUTPUT
+#define DEFAULT_OUTPUT_MODE OUTPUT_MODE_ARCADE
 
 /** Manages handling touch events and updating touch state */
 TouchSlider* touch_slider;
+/** Samples the IR sensors of the air towers in the background and tracks which beams are blocked */
+AirSensor* air_sensor;
+/** Reads the test, service and function buttons */
+Buttons* buttons;
+/** Picks the output mode at boot, and switches it when the function button is held */
+ModeSelector* mode_selector;
 /** Manages the LED strip and abstracts away LED indices from key and divider indices */
 LedController* led_strip;
+/** Hands frames of reactive lighting from core 1, which renders them, to core 0, which sends them to the LEDs */
+LedSwapChain* led_swap_chain;
+/** Renders the reactive lighting effects in keyboard mode, on core 1 */
+ReactiveLighting* reactive_lighting;
 /** Handles sending keyboard outputs to the host computer */
 UsbOutput* usb_output;
 /** Handles reading serial packets for slider and LED board emulation, including unescaping logic */
 SegaSerialReader* sega_serial;
 /** Handles packet processing for adhering to the SEGA slider protocol */
 SegaSlider* sega_slider;
+/** Paces the automatic slider reports in AC protocol emulation mode */
+SliderReportScheduler* report_scheduler;
 /** Handles packet processing for adhering to the SEGA 15093-06 LED board protocol */
 SegaLedBoard* sega_led_board;
+/** Emulates the IO4 board over HID in arcade mode, for the air sensors and buttons */
+SegaIo4* sega_io4;
 /** Re-usable packet structure for incoming slider packets. */
 SliderPacket slider_request;
 /** Re-usable packet structure for incoming LED board request packets */
 LedRequestPacket led_request;
-/** This keeps track of the touch states of the keys for reactive lighting updates (combines each key's sensors into one ORed state) */
-bool key_states[16] = { false };
-/** This flag indicates that the light state has been updated and the lights should be refreshed (not for arcade protocol mode) */
-bool update_lights = false;
+/** When the device last connected to the bus, for timing enumeration */
+uint32_t usb_connect_us;
+/** How long the last enumeration took, from connecting to the host setting the configuration, in microseconds */
+uint32_t usb_enumeration_us;
+/** How many times the host has configured the device since boot */
+uint32_t usb_mount_count;
 
-void main_core_1();
+/**
+ * @brief Invoked by TinyUSB when the host sets the configuration, which finishes enumeration.
+ */
+void tud_mount_cb(void) {
+    usb_enumeration_us = time_us_32() - usb_connect_us;
+    usb_mount_count++;
+}
+
+/**
+ * @brief Invoked by TinyUSB when the device is disconnected from the host, which enumerates it again on reconnecting.
+ */
+void tud_umount_cb(void) {
+    usb_connect_us = time_us_32();
+}
+
+/**
+ * @brief Logs the average and worst-case time from an LED change being submitted to it being sent to the
+ * LEDs, for each source of LED changes, then resets the statistics.
+ */
+void log_led_latency() {
+    const char* names[LED_SOURCE_COUNT] = { "Slider", "LED board 0", "LED board 1", "Reactive" };
+
+    for (int i = 0; i < LED_SOURCE_COUNT; i++) {
+        if (led_strip->source_latency_us[i].count > 0) {
+            printf("[Core 0] %s LED latency: avg %u us | max %u us\n",
+                names[i], led_strip->source_latency_us[i].average(), led_strip->source_latency_us[i].max);
+        }
+    }
+
+    led_strip->reset_latency_stats();
+}
+
+/**
+ * @brief Logs the average and worst-case latency from a USB OUT transfer completing to its packet being
+ * dispatched, for each of the emulated serial devices, then resets the statistics.
+ */
+void log_serial_latency() {
+    const char* names[3] = { "Slider", "LED board 0", "LED board 1" };
+
+    for (int i = 0; i < 3; i++) {
+        uint32_t count = sega_serial->dispatch_count[i];
+        uint32_t average = count == 0 ? 0 : sega_serial->dispatch_latency_total_us[i] / count;
+
+        printf("[Core 0] %s dispatch latency: avg %u us | max %u us | max from SYNC %u us\n",
+            names[i], average, sega_serial->dispatch_latency_max_us[i], sega_serial->packet_latency_max_us[i]);
+    }
+
+    sega_serial->reset_latency_stats();
+}
+
+/**
+ * @brief Logs how long the host took to enumerate the device, and how many times it has done so.
+ */
+void log_usb_enumeration() {
+    if (usb_mount_count > 0) {
+        printf("[Core 0] USB enumeration: %u us in %s mode%s | %u times since boot\n", usb_enumeration_us,
+            usb_output_mode == OUTPUT_MODE_KEYBOARD ? "keyboard" : "arcade",
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+            " (combined baseline configuration)",
+#else
+            "",
+#endif
+            usb_mount_count);
+    }
+}
 
 /**
  * @brief Initializes the GPIO pins, sets up I2C, etc.
@@ -78,23 +216,144 @@ void init_gpio() {
 }
 
 /**
- * @brief Main firmware entrypoint.
+ * @brief Logs the LED statistics shared by both modes, then resets them.
  */
-int main() {
-    tusb_init();
-    stdio_init_all();
-    init_gpio();
+void log_led_stats() {
+    printf("[Core 0] LED show: avg %u cycles | max %u cycles | %u frames/s shown | %u frames/s suppressed\n",
+        led_strip->show_cycles.average(), led_strip->show_cycles.max,
+        led_strip->frames_shown() * (1000 / LOG_DELAY), led_strip->frames_suppressed() * (1000 / LOG_DELAY));
+    led_strip->show_cycles.reset();
+    led_strip->reset_frame_counts();
+    log_led_latency();
+
+#ifdef BENCHMARK_INTERP_KERNELS
+    interp_kernels_benchmark();
+#endif
 
-    // Initialize inputs and outputs
-    touch_slider = new TouchSlider();
-    led_strip = new LedController(100);
+#ifdef BENCHMARK_LED_MATH
+    led_math_benchmark();
+#endif
+
+#ifdef BENCHMARK_STATIC_STRIP
+    static_strip_benchmark(led_strip->strip());
+#endif
+
+    printf("[Core 0] LED current: avg %u mA | max %u mA | %u frames/s dimmed for power\n",
+        led_strip->estimated_current_ma.average(), led_strip->estimated_current_ma.max,
+        led_strip->current_limited_frames * (1000 / LOG_DELAY));
+    led_strip->estimated_current_ma.reset();
+    led_strip->current_limited_frames = 0;
+}
+
+/**
+ * @brief Logs the input scan rate and the air sensor levels from core 1.
+ * @param scan_count How many times the inputs were scanned since the last log
+ * @param air_update_count The beam update count as of the last log, which is updated to the current count
+ */
+void log_inputs(uint32_t scan_count, uint32_t* air_update_count) {
+    printf("[Core 1] Input scan rate: %i Hz\n", scan_count * (1000 / LOG_DELAY));
+
+    uint32_t air_updates = air_sensor->get_beam_update_count();
+    printf("[Core 1] Air sensors: %u Hz per beam | levels %u %u %u %u %u %u | blocked 0x%02x\n",
+        (air_updates - *air_update_count) * (1000 / LOG_DELAY),
+        air_sensor->levels[0], air_sensor->levels[1], air_sensor->levels[2],
+        air_sensor->levels[3], air_sensor->levels[4], air_sensor->levels[5], air_sensor->get_states());
+    *air_update_count = air_updates;
+}
+
+/**
+ * @brief Entrypoint for core 1 in keyboard mode. Scans the inputs, and renders the reactive lighting from them.
+ */
+void core_1_keyboard_mode() {
+    // Keep track of the scan rate and log it each second
+    uint32_t time_now = to_ms_since_boot(get_absolute_time());
+    uint32_t time_log = time_now + LOG_DELAY;
+    uint32_t scan_count = 0;
+    uint32_t air_update_count = air_sensor->get_beam_update_count();
+    uint32_t touch_change_count = touch_slider->change_count;
+
+    // SysTick is per core, so it needs starting here as well for measuring render times
+    cycle_counter_init();
+
+    while (true) {
+        // Scan the touch keys
+        touch_slider->scan_touch_states();
+
+        // Pick up the latest air sensor levels, which are sampled in the background
+        air_sensor->update();
+
+        // Feed touch changes to the reactive lighting, and render its next frame once one is due
+        if (touch_slider->change_count != touch_change_count) {
+            touch_change_count = touch_slider->change_count;
+            reactive_lighting->set_pressed_keys(touch_slider->get_pressed_keys());
+        }
+
+        reactive_lighting->render_if_due(time_us_32());
+
+        scan_count++;
+
+        // Log the current touch scan rate once per second
+        time_now = to_ms_since_boot(get_absolute_time());
+
+        if (time_now > time_log) {
+            log_inputs(scan_count, &air_update_count);
+            time_log = time_now + LOG_DELAY;
+            scan_count = 0;
+
+            printf("[Core 1] Reactive lighting: avg %u cycles | max %u cycles | %u frames/s | %u frames/s replaced before shown\n",
+                reactive_lighting->render_cycles.average(), reactive_lighting->render_cycles.max,
+                led_swap_chain->frames_published * (1000 / LOG_DELAY), led_swap_chain->frames_replaced * (1000 / LOG_DELAY));
+            reactive_lighting->render_cycles.reset();
+            led_swap_chain->reset_stats();
+        }
+    }
+}
+
+/**
+ * @brief Entrypoint for core 1 in arcade mode. Scans the inputs, and builds the slider reports from them.
+ */
+void core_1_arcade_mode() {
+    // Keep track of the scan rate and log it each second
+    uint32_t time_now = to_ms_since_boot(get_absolute_time());
+    uint32_t time_log = time_now + LOG_DELAY;
+    uint32_t scan_count = 0;
+    uint32_t air_update_count = air_sensor->get_beam_update_count();
+
+    while (true) {
+        // Scan the touch keys
+        touch_slider->scan_touch_states();
+
+        // Pick up the latest air sensor levels, which are sampled in the background
+        air_sensor->update();
+
+        // Build the next slider report straight away, so core 0 only has to copy it out when it's sent
+        sega_slider->build_slider_report();
+
+        scan_count++;
+
+        // Log the current touch scan rate once per second
+        time_now = to_ms_since_boot(get_absolute_time());
+
+        if (time_now > time_log) {
+            log_inputs(scan_count, &air_update_count);
+            time_log = time_now + LOG_DELAY;
+            scan_count = 0;
+        }
+    }
+}
+
+/**
+ * @brief Runs keyboard mode on core 0: sends the touch, air and button states as keyboard reports, and sends the
+ * reactive lighting frames from core 1 to the LEDs.
+ */
+void run_keyboard_mode() {
+    // The reactive lighting owns the LEDs in keyboard mode. It renders on core 1, and core 0 picks up its frames.
     usb_output = new UsbOutput();
-    sega_serial = new SegaSerialReader();
-    sega_slider = new SegaSlider(touch_slider, led_strip);
-    sega_led_board = new SegaLedBoard(led_strip);
+    led_swap_chain = new LedSwapChain();
+    reactive_lighting = new ReactiveLighting(led_swap_chain, REACTIVE_FRAME_PERIOD_US);
 
     // Launch the input code on the second core
-    multicore_launch_core1(main_core_1);
+    multicore_launch_core1(core_1_keyboard_mode);
 
     // Keep track of the output rate and log it each second
     uint32_t time_now = to_ms_since_boot(get_absolute_time());
@@ -102,48 +361,87 @@ int main() {
     uint32_t output_count = 0;
     uint32_t lights_update_count = 0;
 
-#ifdef USE_KEYBOARD_OUTPUT
-    // Limit how often we update lights in keyboard mode, relative to how often we send USB updates
-    uint32_t lights_update_limiter = 0;
-#else
-    // Limit how often we send slider touch reports in AC protocol emulation mode
-    uint32_t time_send_report = time_now + SLIDER_REPORT_DELAY;
-    uint32_t time_last_serial_packet = time_now;
-#endif
-
     while (true) {
         // tinyusb device task, required to call this frequently since we're
         // not using a RTOS
         tud_task();
 
-#ifdef USE_KEYBOARD_OUTPUT
         // Check if the host is ready to receive another USB packet
         if (tud_hid_ready()) {
-            // Send the keyboard updates
+            // Send the keyboard updates. The air states come from core 1's last update, and the buttons are
+            // tracked by their interrupts, so both are current as of this report.
             usb_output->set_slider_sensors(touch_slider->states);
+            usb_output->set_air_sensors(air_sensor->get_states());
+            usb_output->set_buttons(buttons->get_states());
             usb_output->send_update();
+            output_count++;
+        }
 
-            // Update the lights if necessary, based on how many USB frames
-            // to skip before updating the lights
-            if (lights_update_limiter == (LIGHTS_UPDATE_DIVISOR - 1)) {
-                if (update_lights) {
-                    led_strip->update();
-                    update_lights = false;
-                }
+        // Pick up the newest frame of reactive lighting from core 1, and hand it to the LED frame scheduler
+        const LedFrame* reactive_frame = led_swap_chain->take_latest();
 
-                lights_update_limiter = 0;
-                lights_update_count++;
-            } else {
-                lights_update_limiter++;
-            }
+        if (reactive_frame != NULL) {
+            led_strip->load_frame(reactive_frame);
+            led_strip->submit(LED_SOURCE_REACTIVE);
+        }
 
-            output_count++;
+        // Send the reactive lighting to the strip, once a frame is due
+        if (led_strip->commit_if_due()) {
+            lights_update_count++;
         }
 
+        mode_selector->check_for_switch();
+
+        // Log the current output rate once per second
         time_now = to_ms_since_boot(get_absolute_time());
 
-#else
-        // Check if any serial packets are available for the slider, and process them if so
+        if (time_now > time_log) {
+            printf("[Core 0] Output rate: %i Hz | LED update rate: %i Hz\n",
+                output_count * (1000 / LOG_DELAY), lights_update_count * (1000 / LOG_DELAY));
+            time_log = time_now + LOG_DELAY;
+            output_count = 0;
+            lights_update_count = 0;
+
+            log_led_stats();
+            log_usb_enumeration();
+        }
+    }
+}
+
+/**
+ * @brief Runs arcade mode on core 0: emulates the slider and the LED boards over serial, and the IO4 over HID.
+ */
+void run_arcade_mode() {
+    led_strip->set_interpolation(LED_INTERPOLATION_US);
+    sega_serial = new SegaSerialReader();
+    sega_slider = new SegaSlider(touch_slider, led_strip);
+    sega_led_board = new SegaLedBoard(led_strip);
+    sega_io4 = new SegaIo4(air_sensor, buttons);
+
+    // Launch the input code on the second core
+    multicore_launch_core1(core_1_arcade_mode);
+
+    // Keep track of the output rate and log it each second
+    uint32_t time_now = to_ms_since_boot(get_absolute_time());
+    uint32_t time_log = time_now + LOG_DELAY;
+    uint32_t output_count = 0;
+    uint32_t lights_update_count = 0;
+
+    // Limit how often we send slider touch reports
+    report_scheduler = new SliderReportScheduler(SLIDER_REPORT_PERIOD_US);
+    uint32_t time_last_serial_packet = time_now;
+
+#ifdef SLIDER_REPORT_ON_CHANGE
+    report_scheduler->set_report_on_change(true, SLIDER_HEARTBEAT_US);
+#endif
+
+    while (true) {
+        // tinyusb device task, required to call this frequently since we're
+        // not using a RTOS
+        tud_task();
+
+        // Check if any serial packets are available for the slider, and process them if so. These
+        // return immediately unless TinyUSB has flagged that new data arrived on the interface.
         if (sega_serial->read_slider_packet(&slider_request)) {
             time_last_serial_packet = time_now;
             sega_slider->process_packet(&slider_request);
@@ -168,17 +466,28 @@ int main() {
             sega_led_board->process_packet(&led_request, 1);
         }
 
+        // Send the air sensors and buttons through the IO4 every time the host polls for them (every 1ms)
+        sega_io4->send_report();
+
         time_now = to_ms_since_boot(get_absolute_time());
 
-        // Send a slider packet to the host, if auto-reporting is enabled, every X ms
-        if (time_now >= time_send_report
-                && sega_slider->auto_send_reports
-                && !sega_serial->slider_packet_in_progress()) {
-            sega_slider->send_slider_report();
-            output_count++;
-            time_send_report = time_now + SLIDER_REPORT_DELAY;
+        // Send a slider packet to the host whenever the report alarm fires (or the touch states change, when
+        // reporting on change), if auto-reporting is enabled. CDC is full duplex, so this doesn't need to wait
+        // for any in-progress packet from the host.
+        if (report_scheduler->report_due(sega_slider->published_change_count)) {
+            if (sega_slider->auto_send_reports) {
+                sega_slider->send_slider_report();
+                report_scheduler->record_report();
+                output_count++;
+            } else {
+                report_scheduler->reset_interval();
+            }
         }
-#endif
+
+        // Send the changes from every LED source to the strip as one frame, once one is due
+        led_strip->commit_if_due();
+
+        mode_selector->check_for_switch();
 
         // Log the current output rate once per second
         if (time_now > time_log) {
@@ -187,56 +496,69 @@ int main() {
             time_log = time_now + LOG_DELAY;
             output_count = 0;
             lights_update_count = 0;
+
+            log_led_stats();
+            log_usb_enumeration();
+            log_serial_latency();
+
+            printf("[Core 0] Slider report interval: min %u us | max %u us | p99 %u us%s\n",
+                report_scheduler->interval_min_us == UINT32_MAX ? 0 : report_scheduler->interval_min_us,
+                report_scheduler->interval_max_us, report_scheduler->interval_percentile_us(99),
+                report_scheduler->polling_clock ? " | no alarm free, polling the clock" : "");
+            report_scheduler->reset_stats();
+
+            printf("[Core 0] Slider report data age: avg %u us | max %u us\n",
+                sega_slider->report_count == 0 ? 0 : sega_slider->report_age_total_us / sega_slider->report_count,
+                sega_slider->report_age_max_us);
+            sega_slider->reset_report_stats();
+
+            printf("[Core 0] IO4 report rate: %u Hz | buttons 0x%02x\n",
+                sega_io4->report_count * (1000 / LOG_DELAY), buttons->get_states());
+            sega_io4->report_count = 0;
+
+            printf("[Core 0] LED report decode: avg %u cycles | max %u cycles\n",
+                led_strip->blit_cycles.average(), led_strip->blit_cycles.max);
+            led_strip->blit_cycles.reset();
+
+            printf("[Core 0] LED interpolation: avg %u cycles | max %u cycles\n",
+                led_strip->interpolation_cycles.average(), led_strip->interpolation_cycles.max);
+            led_strip->interpolation_cycles.reset();
         }
     }
-
-    return 0;
 }
 
 /**
- * @brief Entrypoint for the second core. Currently, core1 is responsible for polling all the inputs,
- * while core0 will be responsible for outputs.
+ * @brief Main firmware entrypoint. Sets up everything both modes share, then hands over to the loops of the mode
+ * picked at boot, so the loops themselves never have to check the mode.
  */
-void main_core_1() {
-    // Keep track of the scan rate and log it each second
-    uint32_t time_now = to_ms_since_boot(get_absolute_time());
-    uint32_t time_log = time_now + LOG_DELAY;
-    uint32_t scan_count = 0;
-
-    // Infinite loop to read all the input data from various sources
-    while (true) {
-        // Scan the touch keys
-        touch_slider->scan_touch_states();
-
-#ifdef USE_KEYBOARD_OUTPUT
-        // Set the slider LEDs according to touch sensor states,
-        // but let core 0 handle the actual call to *show* the lights
-        for (int i = 0; i < 16; i++) {
-            bool key_pressed = touch_slider->is_key_pressed(i);
+int main() {
+    init_gpio();
+    cycle_counter_init();
 
-            if (key_pressed != key_states[i]) {
-                if (key_pressed) {
-                    led_strip->set_key(i, BLUE);
-                } else {
-                    led_strip->set_key(i, YELLOW);
-                }
+    // Pick the mode before connecting to the host, since the mode decides which interfaces the host sees
+    buttons = new Buttons();
+    mode_selector = new ModeSelector(buttons, DEFAULT_OUTPUT_MODE);
+    usb_output_mode = mode_selector->get_mode();
 
-                update_lights = true;
-            }
-
-            key_states[i] = key_pressed;
-        }
-#endif
+    usb_connect_us = time_us_32();
+    tusb_init();
+    stdio_init_all();
 
-        scan_count++;
+    // Initialize the inputs and outputs both modes use
+    touch_slider = new TouchSlider();
+    air_sensor = new AirSensor(pio1);
+    led_strip = new LedController(100);
+    led_strip->set_frame_timing(LED_FRAME_PERIOD_US, LED_MAX_LATENCY_US);
 
-        // Log the current touch scan rate once per second
-        time_now = to_ms_since_boot(get_absolute_time());
+    // Give the IR receivers a moment to settle, then set the beam thresholds from their clear levels
+    sleep_ms(10);
+    air_sensor->calibrate();
 
-        if (time_now > time_log) {
-            printf("[Core 1] Input scan rate: %i Hz\n", scan_count * (1000 / LOG_DELAY));
-            time_log = time_now + LOG_DELAY;
-            scan_count = 0;
-        }
+    if (usb_output_mode == OUTPUT_MODE_KEYBOARD) {
+        run_keyboard_mode();
+    } else {
+        run_arcade_mode();
     }
+
+    return 0;
 }
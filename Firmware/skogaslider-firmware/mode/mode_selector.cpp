@@ -0,0 +1,122 @@
+/**
+ * @file mode_selector.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-21
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <string.h>
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "pico/multicore.h"
+#include "tusb.h"
+#include "mode_selector.h"
+
+/**
+ * @brief The record kept at the start of the mode's flash sector.
+ */
+struct StoredMode {
+    uint32_t magic;
+    uint8_t mode;
+};
+
+/**
+ * @brief Construct a new ModeSelector::ModeSelector object, and picks the mode to boot into.
+ * @param buttons The buttons, for reading the function button
+ * @param default_mode The mode to use when none has been stored yet
+ */
+ModeSelector::ModeSelector(Buttons* buttons, uint8_t default_mode) :
+    buttons(buttons),
+    mode(load_mode(default_mode)),
+    last_check_us(time_us_32())
+{
+    if (buttons->is_pressed(BUTTON_FUNCTION)) {
+        mode = (mode + 1) % OUTPUT_MODE_COUNT;
+        save_mode(mode);
+    }
+}
+
+/**
+ * @brief Returns the stored mode, or the given default if flash doesn't hold a valid one.
+ */
+uint8_t ModeSelector::load_mode(uint8_t default_mode) {
+    const StoredMode* stored = (const StoredMode*) (XIP_BASE + MODE_FLASH_OFFSET);
+
+    if (stored->magic != MODE_FLASH_MAGIC || stored->mode >= OUTPUT_MODE_COUNT) {
+        return default_mode;
+    }
+
+    return stored->mode;
+}
+
+/**
+ * @brief Writes the given mode to flash, unless it's already stored. Nothing may run from flash while this runs, so
+ * core 1 must not be running, and interrupts are disabled on this core.
+ */
+void ModeSelector::save_mode(uint8_t mode) {
+    const StoredMode* stored = (const StoredMode*) (XIP_BASE + MODE_FLASH_OFFSET);
+
+    if (stored->magic == MODE_FLASH_MAGIC && stored->mode == mode) {
+        return;
+    }
+
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+
+    StoredMode record = { MODE_FLASH_MAGIC, mode };
+    memcpy(page, &record, sizeof(record));
+
+    uint32_t interrupts = save_and_disable_interrupts();
+    flash_range_erase(MODE_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(MODE_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(interrupts);
+}
+
+/**
+ * @brief Returns the output mode the device booted into.
+ */
+uint8_t ModeSelector::get_mode() {
+    return mode;
+}
+
+/**
+ * @brief Switches to the other mode if the function button has been held for MODE_SWITCH_HOLD_US. Cheap enough to
+ * call on every iteration of the main loop, since it only looks at the button every MODE_SWITCH_CHECK_US.
+ */
+void ModeSelector::check_for_switch() {
+    uint32_t now = time_us_32();
+
+    if (now - last_check_us < MODE_SWITCH_CHECK_US) {
+        return;
+    }
+
+    last_check_us = now;
+
+    // A hold that started before boot already picked the mode, so only count holds after the button was pressed again
+    if (buttons->get_press_count(BUTTON_FUNCTION) == 0) {
+        return;
+    }
+
+    if (buttons->get_held_us(BUTTON_FUNCTION) >= MODE_SWITCH_HOLD_US) {
+        switch_mode((mode + 1) % OUTPUT_MODE_COUNT);
+    }
+}
+
+/**
+ * @brief Stores the given mode and reboots into it. Must be called from core 0, and never returns.
+ */
+void ModeSelector::switch_mode(uint8_t new_mode) {
+    // Core 1 runs from flash, so it has to be stopped before the flash is written
+    multicore_reset_core1();
+    save_mode(new_mode);
+
+    // Drop off the bus first, so the host removes the old interfaces before the new ones show up
+    tud_disconnect();
+    sleep_ms(MODE_SWITCH_DISCONNECT_MS);
+    watchdog_reboot(0, 0, 0);
+
+    while (true) {
+        tight_loop_contents();
+    }
+}
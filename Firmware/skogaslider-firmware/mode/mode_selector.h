@@ -0,0 +1,48 @@
+/**
+ * @file mode_selector.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-21
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+#include "../buttons/buttons.h"
+#include "../tinyusb/usb_descriptors.h"
+
+/** How long the function button has to be held to switch to the other output mode, in microseconds */
+#define MODE_SWITCH_HOLD_US 3000000
+
+/** How often to check whether the function button has been held long enough, in microseconds */
+#define MODE_SWITCH_CHECK_US 10000
+
+/** How long to stay off the bus before rebooting into the new mode, so the host sees the device leave */
+#define MODE_SWITCH_DISCONNECT_MS 100
+
+/** Where the output mode is stored in flash: the last sector, well clear of the firmware */
+#define MODE_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+/** Marks the sector as holding a stored mode, rather than erased flash or leftovers from other firmware */
+#define MODE_FLASH_MAGIC 0x534B4D44
+
+/**
+ * @brief Picks the output mode at boot, and switches it at runtime. The mode is kept in flash. Holding the function
+ * button while plugging in switches to the other mode straight away, and holding it for MODE_SWITCH_HOLD_US while
+ * running stores the other mode and reboots, so the device re-enumerates with the interfaces of the new mode. This
+ * has to be constructed before core 1 is launched, since core 1 can't run from flash while it's being written.
+ */
+class ModeSelector {
+    private:
+        Buttons* buttons;
+        uint8_t mode;
+        uint32_t last_check_us;
+
+        static uint8_t load_mode(uint8_t default_mode);
+        static void save_mode(uint8_t mode);
+    public:
+        ModeSelector(Buttons* buttons, uint8_t default_mode);
+        uint8_t get_mode();
+        void check_for_switch();
+        void switch_mode(uint8_t new_mode);
+};
@@ -0,0 +1,72 @@
+/**
+ * @file cycle_counter.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-09
+ * @brief Helpers for measuring how many CPU cycles a piece of code takes, using the Cortex-M0+ SysTick timer. SysTick
+ * is local to each core, so cycle_counter_init() needs to be called on every core that takes measurements.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico.h"
+#include "hardware/structs/systick.h"
+
+/** SysTick is a 24-bit down-counter */
+#define SYSTICK_MASK 0x00FFFFFF
+
+/**
+ * @brief Starts SysTick free-running from the processor clock, without raising any interrupts.
+ */
+static inline void cycle_counter_init() {
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;
+}
+
+/**
+ * @brief Reads the current cycle count, to be passed to cycles_since() later.
+ */
+static inline uint32_t cycle_counter_read() {
+    return systick_hw->cvr;
+}
+
+/**
+ * @brief Returns how many cycles have passed since the given count was read. Only valid for measurements shorter
+ * than 2^24 cycles (around 134ms at 125MHz).
+ */
+static inline uint32_t cycles_since(uint32_t start) {
+    return (start - systick_hw->cvr) & SYSTICK_MASK;
+}
+
+/**
+ * @brief Keeps the average and worst case of a measurement between resets, usually once per log interval.
+ */
+struct CycleStats {
+    /** The largest measurement recorded */
+    uint32_t max;
+    /** The sum of all recorded measurements */
+    uint32_t total;
+    /** How many measurements were recorded */
+    uint32_t count;
+
+    void record(uint32_t value) {
+        total += value;
+        count++;
+
+        if (value > max) {
+            max = value;
+        }
+    }
+
+    uint32_t average() const {
+        return count == 0 ? 0 : total / count;
+    }
+
+    void reset() {
+        max = 0;
+        total = 0;
+        count = 0;
+    }
+};
@@ -0,0 +1,258 @@
+/**
+ * @file interp_kernels.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-16
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "interp_kernels.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/interp.h"
+#include "cycle_counter.h"
+#endif
+
+/**
+ * @brief Every 6-bit value with its bits reversed, so 12 electrodes can be reversed with 2 lookups.
+ */
+struct Reverse6Table {
+    uint8_t values[64];
+
+    constexpr Reverse6Table() : values() {
+        for (uint8_t i = 0; i < 64; i++) {
+            for (uint8_t bit = 0; bit < 6; bit++) {
+                values[i] |= ((i >> bit) & 0x01) << (5 - bit);
+            }
+        }
+    }
+};
+
+static constexpr Reverse6Table reverse6 = Reverse6Table();
+
+static_assert(reverse6.values[0x01] == 0x20 && reverse6.values[0x2C] == 0x0D, "6-bit reverse table is wrong");
+
+/**
+ * @brief Packs a BRG triple from an LED report into the GRB word the strip sends over the wire.
+ */
+static inline uint32_t wire_word(const uint8_t* brg) {
+    return (brg[2] << 24) | (brg[1] << 16) | (brg[0] << 8);
+}
+
+/**
+ * @brief Writes a GRB word to every LED of the given slot.
+ */
+static inline void fill_slot(uint32_t* pixels, LedSlot slot, uint32_t word) {
+    uint32_t* pixel = &pixels[slot.first];
+
+    for (uint8_t i = 0; i < slot.count; i++) {
+        pixel[i] = word;
+    }
+}
+
+/**
+ * @brief Turns the touched electrodes of the 3 MPR121s into one bit per sensor, in key order. Each MPR121 is wired
+ * with its electrodes in reverse, so electrode 11 of the first one is sensor 0, and only electrodes 11-4 of the
+ * third one are used.
+ */
+uint32_t pack_touch_bits(const uint16_t* touched) {
+#if PICO_ON_DEVICE
+    return pack_touch_bits_interp(touched);
+#else
+    return pack_touch_bits_scalar(touched);
+#endif
+}
+
+/**
+ * @brief Decodes BRG triples from an LED report into the given slots of the LED chain, one triple per slot.
+ */
+void blit_brg_slots(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count) {
+#if PICO_ON_DEVICE
+    blit_brg_slots_interp(pixels, brg, slots, count);
+#else
+    blit_brg_slots_scalar(pixels, brg, slots, count);
+#endif
+}
+
+/**
+ * @brief Blends count GRB words from one set of colors to another, with a weight of 0 being entirely the first and
+ * 256 entirely the second. The (unused) low byte of each word is left at 0.
+ */
+void blend_pixels(uint32_t* pixels, const uint32_t* from, const uint32_t* to, uint8_t count, uint16_t weight) {
+#if PICO_ON_DEVICE
+    blend_pixels_interp(pixels, from, to, count, weight);
+#else
+    blend_pixels_scalar(pixels, from, to, count, weight);
+#endif
+}
+
+uint32_t pack_touch_bits_scalar(const uint16_t* touched) {
+    uint32_t bits = 0;
+
+    for (uint8_t sensor = 0; sensor < 3; sensor++) {
+        uint16_t value = touched[sensor];
+        uint32_t reversed = (reverse6.values[value & 0x3F] << 6) | reverse6.values[(value >> 6) & 0x3F];
+        bits |= reversed << (sensor * 12);
+    }
+
+    // Bits 32-35 would be electrodes 3-0 of the third MPR121, which aren't wired to any keys
+    return bits;
+}
+
+void blit_brg_slots_scalar(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        fill_slot(pixels, slots[i], wire_word(&brg[i * 3]));
+    }
+}
+
+void blend_pixels_scalar(uint32_t* pixels, const uint32_t* from, const uint32_t* to, uint8_t count, uint16_t weight) {
+    uint32_t inverse = 256 - weight;
+
+    // The channels are blended two at a time, in the even and odd bytes of the word
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t even = ((((from[i] & 0x00FF00FF) * inverse) + ((to[i] & 0x00FF00FF) * weight)) >> 8) & 0x00FF00FF;
+        uint32_t odd = ((((from[i] >> 8) & 0x00FF00FF) * inverse) + (((to[i] >> 8) & 0x00FF00FF) * weight)) & 0xFF00FF00;
+        pixels[i] = even | odd;
+    }
+}
+
+#if PICO_ON_DEVICE
+
+/**
+ * @brief Uses interp1 as a pair of table lookups, with lane 0 giving the address of the reversed low 6 electrodes
+ * and lane 1 (reading the same accumulator) the address of the reversed high 6 electrodes.
+ */
+uint32_t pack_touch_bits_interp(const uint16_t* touched) {
+    interp_config lane0 = interp_default_config();
+    interp_config_set_mask(&lane0, 0, 5);
+    interp_set_config(interp1, 0, &lane0);
+
+    interp_config lane1 = interp_default_config();
+    interp_config_set_cross_input(&lane1, true);
+    interp_config_set_shift(&lane1, 6);
+    interp_config_set_mask(&lane1, 0, 5);
+    interp_set_config(interp1, 1, &lane1);
+
+    interp1->base[0] = (uint32_t) reverse6.values;
+    interp1->base[1] = (uint32_t) reverse6.values;
+
+    uint32_t bits = 0;
+
+    for (uint8_t sensor = 0; sensor < 3; sensor++) {
+        interp1->accum[0] = touched[sensor];
+        uint32_t low = *(const uint8_t*) interp1->peek[0];
+        uint32_t high = *(const uint8_t*) interp1->peek[1];
+        bits |= ((low << 6) | high) << (sensor * 12);
+    }
+
+    return bits;
+}
+
+/**
+ * @brief Uses interp0 to step through the report, with lane 0 adding 3 bytes to the accumulator on every pop and
+ * lane 1 (reading the same accumulator) adding it to the address of the report.
+ */
+void blit_brg_slots_interp(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count) {
+    interp_config lane0 = interp_default_config();
+    interp_set_config(interp0, 0, &lane0);
+
+    interp_config lane1 = interp_default_config();
+    interp_config_set_cross_input(&lane1, true);
+    interp_set_config(interp0, 1, &lane1);
+
+    interp0->accum[0] = 0;
+    interp0->base[0] = 3;
+    interp0->base[1] = (uint32_t) brg;
+
+    for (uint8_t i = 0; i < count; i++) {
+        fill_slot(pixels, slots[i], wire_word((const uint8_t*) interp0->pop[1]));
+    }
+}
+
+/**
+ * @brief Uses interp0 in blend mode, where lane 1 gives base 0 blended towards base 1 by the low 8 bits of its
+ * accumulator. Both bases are loaded with a single write of one channel of each color.
+ */
+void blend_pixels_interp(uint32_t* pixels, const uint32_t* from, const uint32_t* to, uint8_t count, uint16_t weight) {
+    // Blend mode weights go up to 255/256, so a finished blend is just a copy
+    if (weight >= 256) {
+        memcpy(pixels, to, count * sizeof(uint32_t));
+        return;
+    }
+
+    interp_config lane0 = interp_default_config();
+    interp_config_set_blend(&lane0, true);
+    interp_set_config(interp0, 0, &lane0);
+
+    interp_config lane1 = interp_default_config();
+    interp_set_config(interp0, 1, &lane1);
+
+    interp0->accum[1] = weight;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t a = from[i];
+        uint32_t b = to[i];
+        uint32_t pixel = 0;
+
+        for (uint8_t shift = 8; shift < 32; shift += 8) {
+            interp0->base01 = (((b >> shift) & 0xFF) << 16) | ((a >> shift) & 0xFF);
+            pixel |= interp0->peek[1] << shift;
+        }
+
+        pixels[i] = pixel;
+    }
+}
+
+/**
+ * @brief Times every kernel against its plain C version on the calling core, and prints the cycles per call. The
+ * inputs are sized like a real slider LED report and touch scan. Needs cycle_counter_init() to have been called.
+ */
+void interp_kernels_benchmark() {
+    static uint32_t pixels[NUM_RGB_LEDS];
+    static uint32_t from[NUM_RGB_LEDS];
+    static uint32_t to[NUM_RGB_LEDS];
+    static uint8_t brg[NUM_SLIDER_LED_SLOTS * 3];
+    uint16_t touched[3] = { 0x0A5A, 0x0F0F, 0x0C30 };
+    volatile uint32_t sink = 0;
+
+    for (uint8_t i = 0; i < NUM_RGB_LEDS; i++) {
+        from[i] = i * 0x01030500;
+        to[i] = ~from[i] & 0xFFFFFF00;
+    }
+
+    for (uint8_t i = 0; i < sizeof(brg); i++) {
+        brg[i] = i * 7;
+    }
+
+    uint32_t start = cycle_counter_read();
+    sink = pack_touch_bits_scalar(touched);
+    uint32_t touch_scalar = cycles_since(start);
+
+    start = cycle_counter_read();
+    sink = pack_touch_bits_interp(touched);
+    uint32_t touch_interp = cycles_since(start);
+
+    start = cycle_counter_read();
+    blit_brg_slots_scalar(pixels, brg, led_map.slider_report, NUM_SLIDER_LED_SLOTS);
+    uint32_t blit_scalar = cycles_since(start);
+
+    start = cycle_counter_read();
+    blit_brg_slots_interp(pixels, brg, led_map.slider_report, NUM_SLIDER_LED_SLOTS);
+    uint32_t blit_interp = cycles_since(start);
+
+    start = cycle_counter_read();
+    blend_pixels_scalar(pixels, from, to, NUM_RGB_LEDS, 100);
+    uint32_t blend_scalar = cycles_since(start);
+
+    start = cycle_counter_read();
+    blend_pixels_interp(pixels, from, to, NUM_RGB_LEDS, 100);
+    uint32_t blend_interp = cycles_since(start);
+
+    (void) sink;
+    printf("[Kernels] Touch pack: scalar %u cycles | interp %u cycles\n", touch_scalar, touch_interp);
+    printf("[Kernels] Slider blit: scalar %u cycles | interp %u cycles\n", blit_scalar, blit_interp);
+    printf("[Kernels] Blend %u LEDs: scalar %u cycles | interp %u cycles\n", NUM_RGB_LEDS, blend_scalar, blend_interp);
+}
+
+#endif
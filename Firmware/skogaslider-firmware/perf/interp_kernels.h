@@ -0,0 +1,30 @@
+/**
+ * @file interp_kernels.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-16
+ * @brief Small loops run for every touch scan and LED frame. On the Pico these use the hardware interpolators
+ * (interp0 and interp1) of the calling core, and on other builds a plain C version is used instead. Each kernel
+ * sets up the interpolator it uses every time it's called, so they don't rely on any state being kept between
+ * calls, but they mustn't be used from interrupt handlers while the same core is also using the interpolators.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+#include "../leds/led_layout.h"
+
+uint32_t pack_touch_bits(const uint16_t* touched);
+void blit_brg_slots(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count);
+void blend_pixels(uint32_t* pixels, const uint32_t* from, const uint32_t* to, uint8_t count, uint16_t weight);
+
+uint32_t pack_touch_bits_scalar(const uint16_t* touched);
+void blit_brg_slots_scalar(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count);
+void blend_pixels_scalar(uint32_t* pixels, const uint32_t* from, const uint32_t* to, uint8_t count, uint16_t weight);
+
+#if PICO_ON_DEVICE
+uint32_t pack_touch_bits_interp(const uint16_t* touched);
+void blit_brg_slots_interp(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count);
+void blend_pixels_interp(uint32_t* pixels, const uint32_t* from, const uint32_t* to, uint8_t count, uint16_t weight);
+void interp_kernels_benchmark();
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file led_math_benchmark.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdio.h>
+#include <memory>
+#include "led_math_benchmark.h"
+
+#if PICO_ON_DEVICE
+#include <PicoLed.hpp>
+#include "cycle_counter.h"
+
+/** How many LEDs each benchmarked frame covers, the length of the full slider strip */
+#define BENCHMARK_LEDS 65
+
+/**
+ * @brief A target that keeps its pixels in RAM, so frames can be drawn without sending anything to the strip. Its
+ * linear scaling is made public, so it can be timed against the strips' combined brightness and gamma table.
+ */
+class RamTarget: public PicoLed::PicoLedTarget {
+    public:
+        uint32_t pixels[BENCHMARK_LEDS];
+
+        RamTarget(): PicoLed::PicoLedTarget(BENCHMARK_LEDS, PicoLed::GREEN, PicoLed::RED, PicoLed::BLUE,
+            PicoLed::NONE), pixels() {}
+
+        uint32_t getData(uint index) override {
+            return index < BENCHMARK_LEDS ? pixels[index] : 0;
+        }
+
+        void setData(uint index, uint32_t value) override {
+            if (index < BENCHMARK_LEDS) {
+                pixels[index] = value;
+            }
+        }
+
+        using PicoLed::PicoLedTarget::scalePixelData;
+};
+
+/**
+ * @brief Times scaling a frame for the wire the linear way, with gamma correction in front of that, and with the
+ * combined brightness and gamma table the strips use.
+ */
+static void scale_benchmark(RamTarget& target) {
+    static PicoLed::ScaleTable table;
+    static uint32_t wire[BENCHMARK_LEDS];
+    const uint8_t* gamma = PicoLed::Gamma::table.values;
+    table.update(200, true);
+
+    uint32_t start = cycle_counter_read();
+    for (uint i = 0; i < BENCHMARK_LEDS; i++) {
+        wire[i] = target.scalePixelData(target.pixels[i], 200);
+    }
+    uint32_t linear = cycles_since(start);
+
+    start = cycle_counter_read();
+    for (uint i = 0; i < BENCHMARK_LEDS; i++) {
+        uint32_t value = target.pixels[i];
+        uint32_t corrected = (gamma[value >> 24] << 24) | (gamma[(value >> 16) & 0xFF] << 16)
+            | (gamma[(value >> 8) & 0xFF] << 8) | gamma[value & 0xFF];
+        wire[i] = target.scalePixelData(corrected, 200);
+    }
+    uint32_t linear_gamma = cycles_since(start);
+
+    start = cycle_counter_read();
+    for (uint i = 0; i < BENCHMARK_LEDS; i++) {
+        wire[i] = table.scale(target.pixels[i]);
+    }
+    uint32_t combined = cycles_since(start);
+
+    printf("[LED math] Scale %u LEDs: scalePixelData %u cycles | gamma then scalePixelData %u cycles | "
+        "combined table %u cycles\n", BENCHMARK_LEDS, linear, linear_gamma, combined);
+}
+
+void led_math_benchmark() {
+    static std::shared_ptr<RamTarget> target = std::make_shared<RamTarget>();
+    static PicoLed::PicoLedController strip(target);
+    PicoLed::Color start_color = PicoLed::RGB(255, 32, 0);
+    PicoLed::Color end_color = PicoLed::RGB(0, 64, 255);
+    PicoLed::Color fade_color = PicoLed::RGB(12, 200, 90);
+
+    // The gradient used to be worked out with doubles, one MixColors call per pixel
+    uint32_t start = cycle_counter_read();
+    for (uint i = 0; i < BENCHMARK_LEDS; i++) {
+        strip.setPixelColor(i, PicoLed::MixColors(start_color, end_color, (double) i / BENCHMARK_LEDS));
+    }
+    uint32_t gradient_double = cycles_since(start);
+
+    start = cycle_counter_read();
+    strip.fillGradient(start_color, end_color);
+    uint32_t gradient_fixed = cycles_since(start);
+
+    start = cycle_counter_read();
+    strip.fade(fade_color, 0, BENCHMARK_LEDS, 0.25);
+    uint32_t fade_double = cycles_since(start);
+
+    start = cycle_counter_read();
+    strip.fadeFixed(fade_color, 0, BENCHMARK_LEDS, PicoLed::toFixed(0.25));
+    uint32_t fade_fixed = cycles_since(start);
+
+    start = cycle_counter_read();
+    strip.fadeLine(fade_color, 0.5, BENCHMARK_LEDS - 1, 0.25);
+    uint32_t line_double = cycles_since(start);
+
+    start = cycle_counter_read();
+    strip.fadeLineFixed(fade_color, PicoLed::toFixed(0.5), PicoLed::toFixed(BENCHMARK_LEDS - 1), PicoLed::toFixed(0.25));
+    uint32_t line_fixed = cycles_since(start);
+
+    printf("[LED math] Gradient %u LEDs: double %u cycles | fixed %u cycles\n", BENCHMARK_LEDS, gradient_double,
+        gradient_fixed);
+    printf("[LED math] Fade %u LEDs: double %u cycles | fixed %u cycles\n", BENCHMARK_LEDS, fade_double, fade_fixed);
+    printf("[LED math] Fade line %u LEDs: double %u cycles | fixed %u cycles\n", BENCHMARK_LEDS, line_double,
+        line_fixed);
+
+    scale_benchmark(*target);
+}
+
+#endif
@@ -0,0 +1,17 @@
+/**
+ * @file led_math_benchmark.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Times PicoLed's double color math against the Q16 fixed-point versions on the board, and the linear pixel
+ * scaling against the combined brightness and gamma table, for one 65-LED frame each. The frames are drawn into RAM
+ * rather than the real strip, so only the math is measured.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#if PICO_ON_DEVICE
+void led_math_benchmark();
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file led_strip_benchmark.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdio.h>
+#include "led_strip_benchmark.h"
+
+#if PICO_ON_DEVICE
+#include <StaticPioStrip.hpp>
+#include "cycle_counter.h"
+
+/** How many LEDs each benchmarked frame covers, the length of the full slider strip */
+#define BENCHMARK_LEDS 65
+
+/** Instantiates every member of the template, so begin() and show() are compiled too even though they aren't run */
+template class PicoLed::StaticPioStrip<BENCHMARK_LEDS, PicoLed::FORMAT_GRB>;
+
+/**
+ * The static strip is never started with begin(), so it never claims a state machine or DMA channel and nothing is
+ * sent to a pin. Only the pixel writes and their rescaling are timed.
+ */
+static PicoLed::StaticPioStrip<BENCHMARK_LEDS, PicoLed::FORMAT_GRB> static_strip;
+
+/**
+ * @brief Times setPixelColor and fill over a full frame on both strips. The dynamic strip is the one driving the real
+ * LEDs, so each of its pixels is written back with the color it already has, and fill() isn't timed on it; that
+ * leaves the wire data unchanged and the strip isn't marked as needing a new frame. This has to be called from the
+ * core that drives the LEDs.
+ */
+void static_strip_benchmark(PicoLed::PicoLedController& dynamic_strip) {
+    uint num_leds = dynamic_strip.getNumLeds() < BENCHMARK_LEDS ? dynamic_strip.getNumLeds() : BENCHMARK_LEDS;
+    PicoLed::Color color = PicoLed::RGB(255, 32, 0);
+    static_strip.setBrightness(dynamic_strip.getBrightness());
+    static_strip.setGammaCorrection(dynamic_strip.getGammaCorrection());
+
+    uint32_t start = cycle_counter_read();
+    for (uint i = 0; i < num_leds; i++) {
+        dynamic_strip.setPixelColor(i, dynamic_strip.getPixelColor(i));
+    }
+    uint32_t dynamic_pixels = cycles_since(start);
+
+    start = cycle_counter_read();
+    for (uint i = 0; i < num_leds; i++) {
+        static_strip.setPixelColor(i, static_strip.getPixelColor(i));
+    }
+    uint32_t static_pixels = cycles_since(start);
+
+    start = cycle_counter_read();
+    static_strip.fill(color, 0, num_leds);
+    uint32_t static_fill = cycles_since(start);
+
+    // The dynamic strip keeps its object behind a shared_ptr, plus pixel, wire and two frame buffers on the heap
+    uint dynamic_bytes = sizeof(PicoLed::WS2812B) + 4 * num_leds * sizeof(uint32_t);
+
+    printf("[LED strip] Read and write %u pixels: dynamic %u cycles (%u/pixel) | static %u cycles (%u/pixel)\n",
+        num_leds, dynamic_pixels, dynamic_pixels / num_leds, static_pixels, static_pixels / num_leds);
+    printf("[LED strip] Fill %u LEDs: static %u cycles | RAM: dynamic %u bytes | static %u bytes\n", num_leds,
+        static_fill, dynamic_bytes, (uint) sizeof(static_strip));
+}
+
+#endif
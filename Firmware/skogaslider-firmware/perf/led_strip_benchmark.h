@@ -0,0 +1,18 @@
+/**
+ * @file led_strip_benchmark.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Times writing a 65-LED frame through the fixed-size StaticPioStrip against the heap-allocated strip the
+ * firmware drives, and prints how much RAM each of them takes.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#if PICO_ON_DEVICE
+#include <PicoLed.hpp>
+
+void static_strip_benchmark(PicoLed::PicoLedController& dynamic_strip);
+#endif
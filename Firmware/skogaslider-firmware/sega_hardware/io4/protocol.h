@@ -0,0 +1,62 @@
+/**
+ * @file protocol.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-20
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico.h"
+
+// The report IDs and size (IO4_REPORT_ID_INPUT for the input states, IO4_REPORT_ID_RESPONSE for command responses,
+// IO4_REPORT_ID_COMMAND for commands from the host, and IO4_REPORT_SIZE) are shared with the HID report descriptor
+#include "../../tinyusb/usb_descriptors.h"
+
+/** System status reported once the host has configured the board */
+#define IO4_SYSTEM_STATUS_READY 0x30
+
+/** Switch bits in the first button word of the input report */
+#define IO4_BUTTON_TEST (1 << 9)
+#define IO4_BUTTON_SERVICE (1 << 6)
+
+/**
+ * @brief This is an enumeration of the IO4 command IDs we wish to implement.
+ */
+enum Io4CommandId {
+    /** Sets how long the board waits for the host before giving up (not used for this firmware, but acknowledged) */
+    IO4_SET_COMM_TIMEOUT = 0x01,
+    /** Sets how many times inputs are sampled per report (not used for this firmware, but acknowledged) */
+    IO4_SET_SAMPLING_COUNT = 0x02,
+    /** Clears the board status, including coin errors */
+    IO4_CLEAR_BOARD_STATUS = 0x03,
+    /** Sets the general purpose outputs (lamps, not wired on this controller) */
+    IO4_SET_GENERAL_OUTPUT = 0x04,
+    /** Sets the PWM outputs (not wired on this controller) */
+    IO4_SET_PWM_OUTPUT = 0x05,
+    /** Starts a firmware update, which is refused */
+    IO4_UPDATE_FIRMWARE = 0x85
+};
+
+/**
+ * @brief Structure of the input report the IO4 sends every poll. Switches are active-low on the real board, so every
+ * button bit reads 1 while released.
+ */
+struct __packed Io4InputReport {
+    /** Analog inputs, left-aligned 16-bit values */
+    uint16_t adcs[8];
+    /** Rotary encoder counts */
+    uint16_t spinners[4];
+    /** Coin chute counts, in the high byte */
+    uint16_t chutes[2];
+    /** Switch inputs for player 1 and player 2 */
+    uint16_t buttons[2];
+    /** Board status, set to IO4_SYSTEM_STATUS_READY once the host has sent its setup commands */
+    uint8_t system_status;
+    /** USB status */
+    uint8_t usb_status;
+    /** Unused */
+    uint8_t reserved[29];
+};
+
+static_assert(sizeof(Io4InputReport) == IO4_REPORT_SIZE, "IO4 input report must fill the report");
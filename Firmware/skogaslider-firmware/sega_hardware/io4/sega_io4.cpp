@@ -0,0 +1,154 @@
+/**
+ * @file sega_io4.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-20
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <string.h>
+#include "sega_io4.h"
+
+/** Switch bits in the second button word for each air beam, from bottom to top */
+static constexpr uint16_t io4_air_bits[NUM_AIR_SENSORS] = {
+    1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5
+};
+
+SegaIo4* SegaIo4::instance = NULL;
+
+/**
+ * @brief Construct a new SegaIo4::SegaIo4 object. Only one instance can exist, since it answers the HID callbacks.
+ */
+SegaIo4::SegaIo4(AirSensor* _air_sensor, Buttons* _buttons):
+    report_count { 0 },
+    air_sensor { _air_sensor },
+    buttons { _buttons },
+    input_report { },
+    response { 0x00 },
+    response_pending { false }
+{
+    instance = this;
+}
+
+/**
+ * @brief Returns the IO4 being emulated, or NULL if there isn't one (such as in keyboard mode).
+ */
+SegaIo4* SegaIo4::get_instance() {
+    return instance;
+}
+
+/**
+ * @brief Sends the next report to the host if the interface is free, which is a pending command response if there is
+ * one, and the current input states otherwise.
+ * @return Whether a report was sent
+ */
+bool SegaIo4::send_report() {
+    if (!tud_hid_n_ready(HID_INSTANCE_IO4)) {
+        return false;
+    }
+
+    if (response_pending) {
+        response_pending = false;
+        return tud_hid_n_report(HID_INSTANCE_IO4, IO4_REPORT_ID_RESPONSE, response, sizeof(response));
+    }
+
+    build_input_report();
+    report_count++;
+    return tud_hid_n_report(HID_INSTANCE_IO4, IO4_REPORT_ID_INPUT, &input_report, sizeof(input_report));
+}
+
+/**
+ * @brief Fills in the input report from the latest air sensor and button states.
+ */
+void SegaIo4::build_input_report() {
+    uint8_t air_states = air_sensor->get_states();
+    uint8_t button_states = buttons->get_states();
+    uint16_t switches[2] = { 0, 0 };
+
+    if (bit_read(button_states, BUTTON_TEST)) {
+        switches[0] |= IO4_BUTTON_TEST;
+    }
+
+    if (bit_read(button_states, BUTTON_SERVICE)) {
+        switches[0] |= IO4_BUTTON_SERVICE;
+    }
+
+    for (uint8_t i = 0; i < NUM_AIR_SENSORS; i++) {
+        if (bit_read(air_states, i)) {
+            switches[1] |= io4_air_bits[i];
+        }
+    }
+
+    // The switches are active-low, and the function button is wired up as the coin chute
+    input_report.buttons[0] = ~switches[0];
+    input_report.buttons[1] = ~switches[1];
+    input_report.chutes[0] = buttons->get_press_count(BUTTON_FUNCTION) << 8;
+}
+
+/**
+ * @brief Processes a command the host sent in an output report, queueing a response if the command has one.
+ * @param data The output report, without the report ID
+ * @param length The length of the output report
+ */
+void SegaIo4::process_command(const uint8_t* data, uint16_t length) {
+    if (length < 2) {
+        return;
+    }
+
+    switch (data[0]) {
+        case IO4_SET_COMM_TIMEOUT:
+        case IO4_SET_SAMPLING_COUNT:
+            input_report.system_status = IO4_SYSTEM_STATUS_READY;
+            queue_response(data[0], &data[1], 1);
+            break;
+        case IO4_CLEAR_BOARD_STATUS:
+            queue_response(data[0], NULL, 0);
+            break;
+        default:
+            // Outputs aren't wired on this controller, and firmware updates aren't supported
+            break;
+    }
+}
+
+/**
+ * @brief Prepares a response report to be sent in place of the next input report.
+ */
+void SegaIo4::queue_response(uint8_t command, const uint8_t* payload, uint8_t length) {
+    memset(response, 0, sizeof(response));
+    response[0] = command;
+
+    if (length > 0) {
+        memcpy(&response[1], payload, length);
+    }
+
+    response_pending = true;
+}
+
+// TinyUSB HID callbacks, shared by the keyboard (in keyboard mode) and the IO4 (in arcade mode)
+
+uint16_t tud_hid_get_report_cb(
+    uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen
+) {
+    return 0;
+}
+
+void tud_hid_set_report_cb(
+    uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize
+) {
+    SegaIo4* io4 = SegaIo4::get_instance();
+
+    // Commands can arrive as output reports on the interrupt OUT endpoint (where the report ID is still at the start
+    // of the buffer) or as SET_REPORT requests on the control endpoint
+    if (io4 == NULL || itf != HID_INSTANCE_IO4) {
+        return;
+    }
+
+    if (report_id == 0 && report_type == HID_REPORT_TYPE_INVALID && bufsize > 0) {
+        report_id = buffer[0];
+        buffer++;
+        bufsize--;
+    }
+
+    if (report_id == IO4_REPORT_ID_COMMAND) {
+        io4->process_command(buffer, bufsize);
+    }
+}
@@ -0,0 +1,43 @@
+/**
+ * @file sega_io4.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-20
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "tusb.h"
+#include "protocol.h"
+#include "../../air/air_sensor.h"
+#include "../../buttons/buttons.h"
+#include "../../tinyusb/usb_descriptors.h"
+
+/**
+ * @brief Class that emulates the IO4 board over its own HID interface, so the air sensors and the test, service and
+ * function (coin) buttons reach the game with the slider and LED boards, instead of through a separate keyboard hook.
+ * An input report goes out every time the host polls the interface (every 1ms), and commands sent in output reports
+ * are answered on the next poll instead.
+ */
+class SegaIo4 {
+    public:
+        /** How many input reports have been sent, for logging the report rate */
+        uint32_t report_count;
+
+        SegaIo4(AirSensor* _air_sensor, Buttons* _buttons);
+        bool send_report();
+        void process_command(const uint8_t* data, uint16_t length);
+        static SegaIo4* get_instance();
+
+    private:
+        static SegaIo4* instance;
+
+        AirSensor* air_sensor;
+        Buttons* buttons;
+        Io4InputReport input_report;
+        uint8_t response[IO4_REPORT_SIZE];
+        bool response_pending;
+
+        void build_input_report();
+        void queue_response(uint8_t command, const uint8_t* payload, uint8_t length);
+};
@@ -0,0 +1,39 @@
+/**
+ * @file led_board_responses.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief The LED boards' constant responses, fully framed at compile time. These live in their own header so the host
+ * tests can check them against the runtime encoder.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "protocol.h"
+#include "../serial/sega_frame_encoder.h"
+
+/** Board information reported by the LED boards, copied from a real 15093-06 board */
+static constexpr uint8_t board_info_payload[16] = {
+    0x31, 0x35, 0x30, 0x39, 0x33, 0x2D, 0x30, 0x36,
+    0x0A, 0x36, 0x37, 0x31, 0x30, 0x20, 0xFF, 0x90
+};
+/** Board status reported by the LED boards (hardcoded) */
+static constexpr uint8_t board_status_payload[4] = { 0x00, 0x00, 0x00, 0x00 };
+/** Firmware checksum reported by the LED boards (hardcoded) */
+static constexpr uint8_t fw_sum_payload[2] = { 0xAD, 0xF7 };
+/** Protocol version reported by the LED boards (hardcoded) */
+static constexpr uint8_t protocol_ver_payload[3] = { 0x01, 0x01, 0x04 };
+
+// Constant responses, fully framed at compile time so they can be sent with a single write
+static constexpr auto board_info_response = make_led_frame(BOARD_INFO, board_info_payload);
+static constexpr auto board_status_response = make_led_frame(BOARD_STATUS, board_status_payload);
+static constexpr auto fw_sum_response = make_led_frame(FW_SUM, fw_sum_payload);
+static constexpr auto protocol_ver_response = make_led_frame(PROTOCOL_VER, protocol_ver_payload);
+static constexpr auto led_reset_ack = make_led_frame(LED_RESET);
+static constexpr auto set_led_ack = make_led_frame(SET_LED);
+
+// Sanity check the encoder against a hand-framed ACK
+static_assert(led_reset_ack.length == 8, "Unexpected LED_RESET ACK length");
+static_assert(led_reset_ack.bytes[0] == 0xE0 && led_reset_ack.bytes[1] == 0x01 && led_reset_ack.bytes[2] == 0x02
+    && led_reset_ack.bytes[3] == 0x03 && led_reset_ack.bytes[4] == 0x01 && led_reset_ack.bytes[5] == 0x10
+    && led_reset_ack.bytes[6] == 0x01 && led_reset_ack.bytes[7] == 0x18, "Unexpected LED_RESET ACK framing");
@@ -13,6 +13,10 @@
 #define LED_PACKET_BEGIN 0xE0
 /** Byte used to escape any reserved bytes in an LED board packet */
 #define LED_PACKET_ESCAPE 0xD0
+/** Address of the host application in LED board packets */
+#define ADDRESS_HOST 1
+/** Address of the LED board itself in LED board packets */
+#define ADDRESS_BOARD 2
 
 /**
  * @brief This is an enumeration of the LED 15093-06 board command IDs we wish to implement.
@@ -6,17 +6,15 @@
  */
 
 #include "sega_led_board.h"
+#include "led_board_responses.h"
 
 /**
  * @brief Construct a new SegaLedBoard::SegaLedBoard object.
  */
 SegaLedBoard::SegaLedBoard(LedController* _led_strip):
     led_strip { _led_strip },
-    board_info_payload {
-        0x31, 0x35, 0x30, 0x39, 0x33, 0x2D, 0x30, 0x36,
-        0x0A, 0x36, 0x37, 0x31, 0x30, 0x20, 0xFF, 0x90
-    },
     response_payload { 0x00 },
+    frame_buffer { 0x00 },
     led_data_index { 50 * 3, 60 * 3 },
     response_enabled { true }
 {
@@ -35,7 +33,7 @@ void SegaLedBoard::process_packet(LedRequestPacket* request, uint8_t addr) {
 
     switch (request->command) {
         case LED_RESET:
-            response = handle_reset(addr);
+            handle_reset(addr);
             break;
         case SET_TIMEOUT:
             response = handle_set_timeout(request);
@@ -44,27 +42,26 @@ void SegaLedBoard::process_packet(LedRequestPacket* request, uint8_t addr) {
             response = handle_set_disable_response(request, addr);
             break;
         case SET_LED:
-            response = handle_set_led(request, addr);
+            handle_set_led(request, addr);
             break;
         case BOARD_INFO:
-            response = handle_board_info();
+            handle_board_info(addr);
             break;
         case BOARD_STATUS:
-            response = handle_board_status();
+            handle_board_status(addr);
             break;
         case FW_SUM:
-            response = handle_fw_sum();
+            handle_fw_sum(addr);
             break;
         case PROTOCOL_VER:
-            response = handle_protocol_ver();
+            handle_protocol_ver(addr);
             break;
         default:
             break;
     }
 
-    // We shouldn't send responses for LED packets if the responses are disabled; otherwise, every other packet
-    // expects a response in return
-    if (response != NULL && (request->command != SET_LED || response_enabled[addr])) {
+    // Send a response if the packet needed one that couldn't be pre-encoded
+    if (response != NULL) {
         send_packet(response, addr);
     }
 }
@@ -72,12 +69,9 @@ void SegaLedBoard::process_packet(LedRequestPacket* request, uint8_t addr) {
 /**
  * @brief Handles a request to reset the board. Enables responses.
  */
-LedResponsePacket* SegaLedBoard::handle_reset(uint8_t addr) {
+void SegaLedBoard::handle_reset(uint8_t addr) {
     response_enabled[addr] = true;
-    response_packet->command = LED_RESET;
-    response_packet->length = 0;
-    
-    return response_packet;
+    send_frame(led_reset_ack.bytes, led_reset_ack.length, addr);
 }
 
 /**
@@ -107,73 +101,44 @@ LedResponsePacket* SegaLedBoard::handle_set_disable_response(LedRequestPacket* r
 /**
  * @brief Handles a request from the host to get the board information (hardcoded).
  */
-LedResponsePacket* SegaLedBoard::handle_board_info() {
-    response_packet->command = BOARD_INFO;
-    response_packet->length = 16;
-    memcpy(response_packet->payload, board_info_payload, 16);
-
-    return response_packet;
+void SegaLedBoard::handle_board_info(uint8_t addr) {
+    send_frame(board_info_response.bytes, board_info_response.length, addr);
 }
 
 /**
  * @brief Handles a command to get the board status (hardcoded).
  */
-LedResponsePacket* SegaLedBoard::handle_board_status() {
-    response_packet->command = BOARD_STATUS;
-    response_packet->length = 4;
-    response_packet->payload[0] = 0;
-    response_packet->payload[1] = 0;
-    response_packet->payload[2] = 0;
-    response_packet->payload[3] = 0;
-
-    return response_packet;
+void SegaLedBoard::handle_board_status(uint8_t addr) {
+    send_frame(board_status_response.bytes, board_status_response.length, addr);
 }
 
 /**
  * @brief Handles a request for the checksum of the firmware (hardcoded).
  */
-LedResponsePacket* SegaLedBoard::handle_fw_sum() {
-    response_packet->command = FW_SUM;
-    response_packet->length = 2;
-    response_packet->payload[0] = 0xAD;
-    response_packet->payload[1] = 0xF7;
-
-    return response_packet;
+void SegaLedBoard::handle_fw_sum(uint8_t addr) {
+    send_frame(fw_sum_response.bytes, fw_sum_response.length, addr);
 }
 
 /**
  * @brief Returns the (hardcoded) protocol version this board supports.
  */
-LedResponsePacket* SegaLedBoard::handle_protocol_ver() {
-    response_packet->command = PROTOCOL_VER;
-    response_packet->length = 3;
-    response_packet->payload[0] = 0x01;
-    response_packet->payload[1] = 0x01;
-    response_packet->payload[2] = 0x04;
-
-    return response_packet;
+void SegaLedBoard::handle_protocol_ver(uint8_t addr) {
+    send_frame(protocol_ver_response.bytes, protocol_ver_response.length, addr);
 }
 
 /**
- * @brief Handles a request to set the actual LED data for the board.
+ * @brief Handles a request to set the actual LED data for the board. The ACK is only sent if
+ * responses haven't been disabled for this board.
  */
-LedResponsePacket* SegaLedBoard::handle_set_led(LedRequestPacket* request, uint8_t addr) {
-    // Read the correct index to skip over the billboard LED data in the request payload
-    uint8_t index = led_data_index[addr];
-
-    for (uint8_t i = 0; i < 3; i++) {
-        uint8_t blue = request->data[index + (3 * i)];
-        uint8_t red = request->data[index + (3 * i) + 1];
-        uint8_t green = request->data[index + (3 * i) + 2];
-
-        // Set the appropriate tower light
-        led_strip->set_tower(addr, i, red, green, blue);
-    }
+void SegaLedBoard::handle_set_led(LedRequestPacket* request, uint8_t addr) {
+    // Skip over the billboard LED data in the request payload to get to the tower lights
+    led_strip->blit_tower(addr, &request->data[led_data_index[addr]]);
+    led_strip->submit((LedSource) (LED_SOURCE_BOARD_0 + addr));
 
     // Send the response to the host
-    response_packet->command = SET_LED;
-    response_packet->length = 0;
-    return response_packet;
+    if (response_enabled[addr]) {
+        send_frame(set_led_ack.bytes, set_led_ack.length, addr);
+    }
 }
 
 /**
@@ -193,51 +158,36 @@ LedResponsePacket* SegaLedBoard::handle_board_side(uint8_t addr) {
  * @param addr Which tower this packet is for (0 for left, 1 for right)
  */
 void SegaLedBoard::send_packet(LedResponsePacket* packet, uint8_t addr) {
-    uint8_t checksum = 0;
+    uint8_t length = encode_led_frame(
+        frame_buffer, packet->status, packet->command, packet->report, packet->payload, packet->length);
+    send_frame(frame_buffer, length, addr);
+}
+
+/**
+ * @brief Writes an already framed packet to the host and flushes it. Frames larger than the CDC FIFO
+ * are written in chunks, since each full FIFO gets flushed into the endpoint buffer as it's written.
+ * @param bytes The framed packet
+ * @param length The length of the framed packet
+ * @param addr Which tower this packet is for (0 for left, 1 for right)
+ */
+void SegaLedBoard::send_frame(const uint8_t* bytes, uint8_t length, uint8_t addr) {
     uint8_t itf = ITF_LED_0;
+    uint32_t written = 0;
 
     if (addr == 1) {
         itf = ITF_LED_1;
     }
 
-    tud_cdc_n_write_char(itf, LED_PACKET_BEGIN);
-
-    send_escaped_byte(ADDRESS_HOST, itf);
-    checksum += ADDRESS_HOST;
-
-    send_escaped_byte(ADDRESS_BOARD, itf);
-    checksum += ADDRESS_BOARD;
-
-    send_escaped_byte(packet->length + 3, itf);
-    checksum += packet->length + 3;
+    while (written < length) {
+        uint32_t count = tud_cdc_n_write(itf, bytes + written, length - written);
 
-    send_escaped_byte(packet->status, itf);
-    checksum += packet->status;
-
-    send_escaped_byte(packet->command, itf);
-    checksum += packet->command;
-
-    send_escaped_byte(packet->report, itf);
-    checksum += packet->report;
+        // The FIFO is full and the endpoint is still busy, so the rest of the frame is dropped
+        if (count == 0) {
+            break;
+        }
 
-    for (int i = 0; i < packet->length; i++) {
-        send_escaped_byte(packet->payload[i], itf);
-        checksum += packet->payload[i];
+        written += count;
     }
 
-    send_escaped_byte(checksum, itf);
     tud_cdc_n_write_flush(itf);
 }
-
- /**
-  * @brief Sends a byte to the host, escaping it if necessary.
-  */
-void SegaLedBoard::send_escaped_byte(uint8_t byte, uint8_t itf) {
-    if (byte == LED_PACKET_BEGIN || byte == LED_PACKET_ESCAPE) {
-        tud_cdc_n_write_char(itf, LED_PACKET_ESCAPE);
-        byte -= 1;
-    }
-    
-    tud_cdc_n_write_char(itf, byte);
-}
-
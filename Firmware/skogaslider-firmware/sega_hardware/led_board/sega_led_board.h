@@ -11,9 +11,7 @@
 #include "protocol.h"
 #include "../../leds/led_controller.h"
 #include "../serial/sega_serial_reader.h"
-
-#define ADDRESS_HOST 1
-#define ADDRESS_BOARD 2
+#include "../serial/sega_frame_encoder.h"
 
 /**
  * @brief Class that implements the 15093-06 LED board's request and response protocol. This board
@@ -29,20 +27,20 @@ class SegaLedBoard {
         LedController* led_strip;
         LedResponsePacket* response_packet;
         uint8_t response_payload[32];
-        uint8_t board_info_payload[16];
+        uint8_t frame_buffer[led_frame_capacity(32)];
         uint8_t led_data_index[2];
         bool response_enabled[2];
 
         void send_packet(LedResponsePacket* packet, uint8_t addr);
-        LedResponsePacket* handle_reset(uint8_t addr);
+        void send_frame(const uint8_t* bytes, uint8_t length, uint8_t addr);
+        void handle_reset(uint8_t addr);
         LedResponsePacket* handle_set_timeout(LedRequestPacket* request);
         LedResponsePacket* handle_set_disable_response(LedRequestPacket* request, uint8_t addr);
-        LedResponsePacket* handle_set_led(LedRequestPacket* request, uint8_t addr);
-        LedResponsePacket* handle_board_info();
-        LedResponsePacket* handle_board_status();
-        LedResponsePacket* handle_fw_sum();
-        LedResponsePacket* handle_protocol_ver();
+        void handle_set_led(LedRequestPacket* request, uint8_t addr);
+        void handle_board_info(uint8_t addr);
+        void handle_board_status(uint8_t addr);
+        void handle_fw_sum(uint8_t addr);
+        void handle_protocol_ver(uint8_t addr);
         LedResponsePacket* handle_board_side(uint8_t addr);
-        void send_escaped_byte(uint8_t byte, uint8_t itf);
 };
 
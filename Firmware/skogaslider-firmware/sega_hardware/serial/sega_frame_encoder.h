@@ -0,0 +1,146 @@
+/**
+ * @file sega_frame_encoder.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-06
+ * @brief Framing logic (SYNC byte, escaping and checksums) for packets sent to the host by the emulated slider and
+ * LED boards. Everything in here is constexpr, so the exact same code is used to frame packets at runtime and to
+ * pre-encode constant responses at compile time, which can then be answered with a single CDC write.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../slider/protocol.h"
+#include "../led_board/protocol.h"
+
+/**
+ * @brief Returns the worst-case size of a framed slider packet with the given data length, which is the
+ * SYNC byte plus the command ID, length, data and checksum if every single one of them needed escaping.
+ */
+constexpr size_t slider_frame_capacity(size_t length) {
+    return 1 + ((3 + length) * 2);
+}
+
+/**
+ * @brief Returns the worst-case size of a framed LED board response with the given payload length, which is the
+ * SYNC byte plus the addresses, length, status, command, report, payload and checksum if they all needed escaping.
+ */
+constexpr size_t led_frame_capacity(size_t length) {
+    return 1 + ((7 + length) * 2);
+}
+
+/**
+ * @brief A fully framed packet, ready to be written to the host as-is.
+ */
+template <size_t Capacity>
+struct EncodedFrame {
+    /** The framed bytes, only the first `length` of which are valid */
+    uint8_t bytes[Capacity];
+    /** How many bytes of the frame are used */
+    uint8_t length;
+};
+
+/**
+ * @brief Writes a byte into the frame at the given position, escaping it if necessary.
+ * @return uint8_t The position to write the next byte at
+ */
+constexpr uint8_t put_escaped_byte(uint8_t* dst, uint8_t pos, uint8_t byte, uint8_t sync, uint8_t escape) {
+    if (byte == sync || byte == escape) {
+        dst[pos++] = escape;
+        byte -= 1;
+    }
+
+    dst[pos++] = byte;
+    return pos;
+}
+
+/**
+ * @brief Frames a slider packet into the given buffer, which must hold at least slider_frame_capacity(length) bytes.
+ * @return uint8_t The length of the framed packet
+ */
+constexpr uint8_t encode_slider_frame(uint8_t* dst, uint8_t command_id, const uint8_t* data, uint8_t length) {
+    uint8_t checksum = 0;
+    uint8_t pos = 0;
+
+    dst[pos++] = SLIDER_PACKET_BEGIN;
+    checksum -= SLIDER_PACKET_BEGIN;
+
+    pos = put_escaped_byte(dst, pos, command_id, SLIDER_PACKET_BEGIN, SLIDER_PACKET_ESCAPE);
+    checksum -= command_id;
+
+    pos = put_escaped_byte(dst, pos, length, SLIDER_PACKET_BEGIN, SLIDER_PACKET_ESCAPE);
+    checksum -= length;
+
+    for (int i = 0; i < length; i++) {
+        pos = put_escaped_byte(dst, pos, data[i], SLIDER_PACKET_BEGIN, SLIDER_PACKET_ESCAPE);
+        checksum -= data[i];
+    }
+
+    return put_escaped_byte(dst, pos, checksum, SLIDER_PACKET_BEGIN, SLIDER_PACKET_ESCAPE);
+}
+
+/**
+ * @brief Frames an LED board response into the given buffer, which must hold at least led_frame_capacity(length) bytes.
+ * @return uint8_t The length of the framed packet
+ */
+constexpr uint8_t encode_led_frame(
+    uint8_t* dst, uint8_t status, uint8_t command, uint8_t report, const uint8_t* payload, uint8_t length
+) {
+    const uint8_t header[6] = { ADDRESS_HOST, ADDRESS_BOARD, (uint8_t) (length + 3), status, command, report };
+    uint8_t checksum = 0;
+    uint8_t pos = 0;
+
+    dst[pos++] = LED_PACKET_BEGIN;
+
+    for (int i = 0; i < 6; i++) {
+        pos = put_escaped_byte(dst, pos, header[i], LED_PACKET_BEGIN, LED_PACKET_ESCAPE);
+        checksum += header[i];
+    }
+
+    for (int i = 0; i < length; i++) {
+        pos = put_escaped_byte(dst, pos, payload[i], LED_PACKET_BEGIN, LED_PACKET_ESCAPE);
+        checksum += payload[i];
+    }
+
+    return put_escaped_byte(dst, pos, checksum, LED_PACKET_BEGIN, LED_PACKET_ESCAPE);
+}
+
+/**
+ * @brief Pre-encodes a constant slider packet with the given data at compile time.
+ */
+template <size_t Length>
+constexpr EncodedFrame<slider_frame_capacity(Length)> make_slider_frame(uint8_t command_id, const uint8_t (&data)[Length]) {
+    EncodedFrame<slider_frame_capacity(Length)> frame {};
+    frame.length = encode_slider_frame(frame.bytes, command_id, data, Length);
+    return frame;
+}
+
+/**
+ * @brief Pre-encodes a constant slider packet with no data (i.e. an ACK) at compile time.
+ */
+constexpr EncodedFrame<slider_frame_capacity(0)> make_slider_frame(uint8_t command_id) {
+    EncodedFrame<slider_frame_capacity(0)> frame {};
+    frame.length = encode_slider_frame(frame.bytes, command_id, nullptr, 0);
+    return frame;
+}
+
+/**
+ * @brief Pre-encodes a constant LED board response with the given payload at compile time.
+ */
+template <size_t Length>
+constexpr EncodedFrame<led_frame_capacity(Length)> make_led_frame(uint8_t command, const uint8_t (&payload)[Length]) {
+    EncodedFrame<led_frame_capacity(Length)> frame {};
+    frame.length = encode_led_frame(frame.bytes, 1, command, 1, payload, Length);
+    return frame;
+}
+
+/**
+ * @brief Pre-encodes a constant LED board response with no payload (i.e. an ACK) at compile time.
+ */
+constexpr EncodedFrame<led_frame_capacity(0)> make_led_frame(uint8_t command) {
+    EncodedFrame<led_frame_capacity(0)> frame {};
+    frame.length = encode_led_frame(frame.bytes, 1, command, 1, nullptr, 0);
+    return frame;
+}
@@ -7,6 +7,13 @@
 
 #include "sega_serial_reader.h"
 
+/** Set by TinyUSB when new data arrives on a CDC interface, cleared once that interface's FIFO has been drained */
+static volatile bool rx_pending[CFG_TUD_CDC] = { false };
+/** Timestamps of the last USB OUT transfer that completed on each CDC interface */
+static volatile uint32_t rx_time_us[CFG_TUD_CDC] = { 0 };
+/** Timestamps of the last packet SYNC byte that arrived on each CDC interface */
+static volatile uint32_t sync_time_us[CFG_TUD_CDC] = { 0 };
+
 /**
  * @brief Construct a new SegaSerialReader::SegaSerialReader object.
  */
@@ -22,8 +29,18 @@ SegaSerialReader::SegaSerialReader():
     packet_in_progress { false, false, false },
     led_dst_addr { -1, -1 },
     led_src_addr { -1, -1 },
-    slider_command_id { -1 }
+    slider_command_id { -1 },
+    dispatch_latency_max_us { 0, 0, 0 },
+    dispatch_latency_total_us { 0, 0, 0 },
+    packet_latency_max_us { 0, 0, 0 },
+    dispatch_count { 0, 0, 0 }
 {
+#ifdef DETECT_SYNC_BYTES
+    // Have TinyUSB flag the start of every packet as it arrives
+    tud_cdc_n_set_wanted_char(ITF_SLIDER, SLIDER_PACKET_BEGIN);
+    tud_cdc_n_set_wanted_char(ITF_LED_0, LED_PACKET_BEGIN);
+    tud_cdc_n_set_wanted_char(ITF_LED_1, LED_PACKET_BEGIN);
+#endif
 }
 
 /**
@@ -36,6 +53,11 @@ bool SegaSerialReader::read_slider_packet(SliderPacket* dst) {
     uint8_t itf = ITF_SLIDER;
     int next_byte;
 
+    // Nothing has arrived since the FIFO was last drained, so there's nothing to parse
+    if (!rx_pending[itf]) {
+        return false;
+    }
+
     // If we're at the beginning of a packet, we need to read bytes without unescaping
     if (sync[0] == -1) {
         next_byte = read_serial_byte(itf);
@@ -78,6 +100,7 @@ bool SegaSerialReader::read_slider_packet(SliderPacket* dst) {
             dst->length = data_length[0];
             dst->checksum = checksum[0];
             packet_available = true;
+            record_dispatch(itf, 0);
 
             // Reset the packet states for the next read
             sync[0] = -1;
@@ -90,6 +113,9 @@ bool SegaSerialReader::read_slider_packet(SliderPacket* dst) {
         }
     }
 
+    // Stay ready if we stopped at the end of a packet with more bytes still waiting
+    rx_pending[itf] = tud_cdc_n_available(itf) > 0;
+
     return packet_available;
 }
 
@@ -113,6 +139,11 @@ bool SegaSerialReader::read_led_packet(LedRequestPacket* dst, uint8_t addr) {
         serial_buf = &serial_buf_led_2[0];
     }
 
+    // Nothing has arrived since the FIFO was last drained, so there's nothing to parse
+    if (!rx_pending[itf]) {
+        return false;
+    }
+
     // If we're at the beginning of a packet, we need to read bytes without unescaping
     if (sync[index] == -1) {
         next_byte = read_serial_byte(itf);
@@ -158,6 +189,7 @@ bool SegaSerialReader::read_led_packet(LedRequestPacket* dst, uint8_t addr) {
             dst->length = data_length[index] - 1;
             dst->data = &serial_buf[1];
             packet_available = true;
+            record_dispatch(itf, index);
 
             // Reset the packet states for the next read
             sync[index] = -1;
@@ -171,6 +203,9 @@ bool SegaSerialReader::read_led_packet(LedRequestPacket* dst, uint8_t addr) {
         }
     }
 
+    // Stay ready if we stopped at the end of a packet with more bytes still waiting
+    rx_pending[itf] = tud_cdc_n_available(itf) > 0;
+
     return packet_available;
 }
 
@@ -181,6 +216,42 @@ bool SegaSerialReader::slider_packet_in_progress() {
     return packet_in_progress[0];
 }
 
+/**
+ * @brief Resets the packet latency statistics, called after they've been logged.
+ */
+void SegaSerialReader::reset_latency_stats() {
+    for (int i = 0; i < 3; i++) {
+        dispatch_latency_max_us[i] = 0;
+        dispatch_latency_total_us[i] = 0;
+        packet_latency_max_us[i] = 0;
+        dispatch_count[i] = 0;
+    }
+}
+
+/**
+ * @brief Records how long it took for a completed packet to be dispatched, measured from the USB OUT
+ * transfer that delivered its last bytes (and from its SYNC byte, if SYNC detection is enabled).
+ */
+void SegaSerialReader::record_dispatch(uint8_t itf, uint8_t board) {
+    uint32_t time_now = time_us_32();
+    uint32_t latency = time_now - rx_time_us[itf];
+
+    dispatch_latency_total_us[board] += latency;
+    dispatch_count[board]++;
+
+    if (latency > dispatch_latency_max_us[board]) {
+        dispatch_latency_max_us[board] = latency;
+    }
+
+#ifdef DETECT_SYNC_BYTES
+    latency = time_now - sync_time_us[itf];
+
+    if (latency > packet_latency_max_us[board]) {
+        packet_latency_max_us[board] = latency;
+    }
+#endif
+}
+
 /**
  * @brief Reads a single byte from serial for the given interface, or -1
  * if no bytes are available. While reading bytes, if the given escape
@@ -225,3 +296,22 @@ int SegaSerialReader::read_serial_byte(uint8_t itf) {
 
     return return_value;
 }
+
+/**
+ * @brief TinyUSB callback, invoked from tud_task() whenever a USB OUT transfer has been received on a CDC
+ * interface. This marks the interface as ready, so the packet readers only do any work when data has arrived.
+ */
+void tud_cdc_rx_cb(uint8_t itf) {
+    rx_time_us[itf] = time_us_32();
+    rx_pending[itf] = true;
+}
+
+#ifdef DETECT_SYNC_BYTES
+/**
+ * @brief TinyUSB callback, invoked from tud_task() whenever a packet's SYNC byte has been received on a
+ * CDC interface. Used to measure the latency of whole packets, which can span multiple USB transfers.
+ */
+void tud_cdc_rx_wanted_cb(uint8_t itf, char wanted_char) {
+    sync_time_us[itf] = time_us_32();
+}
+#endif
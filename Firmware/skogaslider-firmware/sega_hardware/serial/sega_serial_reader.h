@@ -8,6 +8,7 @@
 #pragma once
 
 #include "pico.h"
+#include "hardware/timer.h"
 #include "tusb.h"
 #include "../slider/protocol.h"
 #include "../led_board/protocol.h"
@@ -19,6 +20,10 @@
 /** Serial interface for LED board 1 */
 #define ITF_LED_1 3
 
+// Comment this out to stop asking TinyUSB to flag the SYNC bytes of incoming packets. When enabled, the time
+// each packet's SYNC byte arrived is tracked as well, so the whole packet latency can be reported.
+#define DETECT_SYNC_BYTES
+
 /**
  * @brief Class to manage reading serial packets for any of the 3 serial devices we present to the host that emulate SEGA
  * hardware devices (slider, or LED boards). This class abstracts away the state machines which manage being able to
@@ -28,10 +33,20 @@
  */
 class SegaSerialReader {
     public:
+        /** Longest time between a USB OUT transfer completing and its packet being dispatched, per packet type */
+        uint32_t dispatch_latency_max_us[3];
+        /** Sum of the dispatch latencies since the last reset, per packet type */
+        uint32_t dispatch_latency_total_us[3];
+        /** Longest time between a packet's SYNC byte arriving and the packet being dispatched, per packet type */
+        uint32_t packet_latency_max_us[3];
+        /** How many packets have been dispatched since the last reset, per packet type */
+        uint32_t dispatch_count[3];
+
         SegaSerialReader();
         bool read_slider_packet(SliderPacket* dst);
         bool read_led_packet(LedRequestPacket* dst, uint8_t addr);
         bool slider_packet_in_progress();
+        void reset_latency_stats();
 
     private:
         /** Buffer to hold in-progress packet data for slider packets */
@@ -61,4 +76,5 @@ class SegaSerialReader {
 
         int read_unescaped_serial_byte(uint8_t itf, uint8_t escape_byte, uint8_t board);
         int read_serial_byte(uint8_t itf);
+        void record_dispatch(uint8_t itf, uint8_t board);
 };
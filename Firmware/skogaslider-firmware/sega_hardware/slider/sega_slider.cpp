@@ -6,6 +6,7 @@
  */
 
 #include "sega_slider.h"
+#include "slider_responses.h"
 
 /**
  * @brief Construct a new SegaSlider::SegaSlider object.
@@ -15,13 +16,18 @@ SegaSlider::SegaSlider(TouchSlider* _slider, LedController* _led_strip):
     led_strip { _led_strip },
     auto_send_reports { false },
     slider_response_data { 0 },
-    hw_info_response_data {
-        0x31, 0x35, 0x33, 0x33, 0x30, 0x20, 0x20, 0x20,
-        0xA0, 0x30, 0x36, 0x37, 0x31, 0x32, 0xFF, 0x90,
-        0x00, 0x64
-    },
-    response_packet { new SliderPacket() }
+    frame_buffer { 0 },
+    report_frames { { 0 }, { 0 } },
+    report_frame_lengths { 0, 0 },
+    report_frame_times_us { 0, 0 },
+    report_sequence { 0 },
+    report_age_max_us { 0 },
+    report_age_total_us { 0 },
+    report_count { 0 },
+    published_change_count { 0 }
 {
+    // Make sure there's always a published report to send, even before the first scan
+    build_slider_report();
 }
 
 /**
@@ -33,17 +39,13 @@ uint8_t SegaSlider::map_touch_to_byte(uint16_t value) {
 }
 
 /**
- * @brief Processes an incoming serial packet from the host. Returns a SliderPacket that is either
- * a valid response, or one whose command ID is NO_OP, indicating no response needed.
+ * @brief Processes an incoming serial packet from the host, sending a response if necessary.
  * @param request The packet from the host
- * @return SliderPacket A response packet, or a  NO_OP packet.
  */
 void SegaSlider::process_packet(SliderPacket* request) {
-    SliderPacket* response = NULL;
-
     switch (request->command_id) {
         case SLIDER_REPORT:
-            response = handle_slider_report();
+            handle_slider_report();
             break;
         case LED_REPORT:
             handle_led_report(request);
@@ -52,45 +54,39 @@ void SegaSlider::process_packet(SliderPacket* request) {
             handle_enable_slider_report();
             break;
         case DISABLE_SLIDER_REPORT:
-            response = handle_disable_slider_report();
+            handle_disable_slider_report();
             break;
         case SLIDER_RESET:
-            response = handle_reset();
+            handle_reset();
             break;
         case GET_HW_INFO:
-            response = handle_get_hw_info();
+            handle_get_hw_info();
             break;
         case SET_SHORT_RAW_COUNT_OFFSET:
-            response = handle_set_short_raw_count_offset();
+            handle_set_short_raw_count_offset();
             break;
         case SET_SHORT_RAW_COUNT_SHIFT:
-            response = handle_set_short_raw_count_shift();
+            handle_set_short_raw_count_shift();
             break;
         default:
             break;
     }
-
-    // Send a response if the packet needed one
-    if (response != NULL) {
-        send_packet(response);
-    }
 }
 
 /**
- * @brief Generates a slider report packet to send to the host, used both for a one-off request for the
- * data, as well as during auto-scan mode.
- * @return SliderPacket A slider report packet containing all sensor readouts
+ * @brief Builds a fully framed slider report from the latest scan and publishes it, ready to be sent by
+ * send_slider_report(). This is called by the scanning core at the end of every scan, so the data is
+ * as fresh as possible and none of the remapping, escaping or checksumming happens at send time.
  */
-SliderPacket* SegaSlider::generate_slider_report() {
-    response_packet->command_id = SLIDER_REPORT;
-    response_packet->data = &slider_response_data[0];
-    response_packet->length = 32;
-
+void SegaSlider::build_slider_report() {
     // Re-order the touch states into the right format. Internally, we store them with sensor 0 in the
     // top-left position on the slider, but Sega has it in the top-right position, meaning we can't
     // do a simple reversal here. Also, we need to map the 10-bit touch values into 8-bit values.
     uint8_t response_index = 0;
 
+    // Every change counted so far is from a scan that's already finished, so this report includes it
+    uint32_t change_count = touch_slider->change_count;
+
 #ifdef FAKE_SLIDER_REPORT_VALUES
     bool* touched_states = touch_slider->states;
     
@@ -113,16 +109,24 @@ SliderPacket* SegaSlider::generate_slider_report() {
     }
 #endif
 
-    return response_packet;
+    // Frame the report into whichever buffer isn't the newest published one, then publish it. The
+    // barrier makes sure the frame is fully written before the other core can see the new sequence,
+    // and the change count is only published after the report that carries the change.
+    uint32_t sequence = report_sequence + 1;
+    uint8_t index = sequence & 1;
+
+    report_frame_lengths[index] = encode_slider_frame(report_frames[index], SLIDER_REPORT, slider_response_data, 32);
+    report_frame_times_us[index] = time_us_32();
+    __dmb();
+    report_sequence = sequence;
+    published_change_count = change_count;
 }
 
 /**
  * @brief Handles a request for a one-off slider report.
- * @return SliderPacket A slider report packet containing all sensor readouts
  */
-SliderPacket* SegaSlider::handle_slider_report() {
-    SliderPacket* response = generate_slider_report();
-    return response;
+void SegaSlider::handle_slider_report() {
+    send_slider_report();
 }
 
 /**
@@ -131,26 +135,8 @@ SliderPacket* SegaSlider::handle_slider_report() {
  */
 void SegaSlider::handle_led_report(SliderPacket* request) {
     led_strip->set_brightness(request->data[0]);
-
-    // The index for the LEDs starts at the right-hand side on the last key
-    // in the LED reports, and the order of the bytes is BRG
-    uint8_t key_index = 15;
-    uint8_t divider_index = 14;
-
-    for (uint8_t i = 0; i < 31; i++) {
-        uint8_t blue = request->data[(i *  3) + 1];
-        uint8_t red = request->data[(i *  3) + 2];
-        uint8_t green = request->data[(i *  3) + 3];
-
-        // Alternate between the keys and dividers
-        if (i % 2 == 0) {
-            led_strip->set_key(key_index--, red, green, blue);
-        } else {
-            led_strip->set_divider(divider_index--, red, green, blue);
-        }
-    }
-
-    led_strip->update();
+    led_strip->blit_slider(&request->data[1]);
+    led_strip->submit(LED_SOURCE_SLIDER);
 }
 
 /**
@@ -162,108 +148,105 @@ void SegaSlider::handle_enable_slider_report() {
 }
 
 /**
- * @brief Handles a request to disable automatic slider reports to the host.
- * @return SliderPacket An ACK response.
+ * @brief Handles a request to disable automatic slider reports to the host, and ACKs it.
  */
-SliderPacket* SegaSlider::handle_disable_slider_report() {
+void SegaSlider::handle_disable_slider_report() {
     auto_send_reports = false;
-    response_packet->command_id = DISABLE_SLIDER_REPORT;
-    response_packet->length = 0;
-
-    return response_packet;
+    send_frame(disable_slider_report_ack.bytes, disable_slider_report_ack.length);
 }
 
 /**
  * @brief Handles a request to reset the board. For now we'll just ACK this and set the auto
  * send flag to false.
- * @return SliderPacket An ACK response.
  */
-SliderPacket* SegaSlider::handle_reset() {
+void SegaSlider::handle_reset() {
     auto_send_reports = false;
-    response_packet->command_id = SLIDER_RESET;
-    response_packet->length = 0;
-
-    return response_packet;
+    send_frame(slider_reset_ack.bytes, slider_reset_ack.length);
 }
 
 /**
- * @brief Handles a request to get the hardware info from the slider.
- * @return SliderPacket A packet containing board info
+ * @brief Handles a request to get the hardware info from the slider, responding with the pre-encoded board info.
  */
-SliderPacket* SegaSlider::handle_get_hw_info() {
-    response_packet->command_id = GET_HW_INFO;
-    response_packet->data = &hw_info_response_data[0];
-    response_packet->length = 18;
-
-    return response_packet;
+void SegaSlider::handle_get_hw_info() {
+    send_frame(hw_info_response.bytes, hw_info_response.length);
 }
 
 /**
  * @brief Handles a request to set the offset for the raw count reports. Just ACK for now.
- * @return SliderPacket*  An ACK response.
  */
-SliderPacket* SegaSlider::handle_set_short_raw_count_offset() {
-    response_packet->command_id = SET_SHORT_RAW_COUNT_OFFSET;
-    response_packet->length = 0;
-
-    return response_packet;
+void SegaSlider::handle_set_short_raw_count_offset() {
+    send_frame(set_short_raw_count_offset_ack.bytes, set_short_raw_count_offset_ack.length);
 }
 
 /**
  * @brief Handles a request to set the shifts for the raw count reports. Just ACK for now.
- * @return SliderPacket*  An ACK response.
  */
-SliderPacket* SegaSlider::handle_set_short_raw_count_shift() {
-    response_packet->command_id = SET_SHORT_RAW_COUNT_SHIFT;
-    response_packet->length = 0;
-
-    return response_packet;
+void SegaSlider::handle_set_short_raw_count_shift() {
+    send_frame(set_short_raw_count_shift_ack.bytes, set_short_raw_count_shift_ack.length);
 }
 
 /**
- * @brief Sends a packet to the host, escaping bytes and checksumming
- * as it does so.
- * @param packet The packet to send to the host
+ * @brief Writes an already framed packet to the host and flushes it. Frames larger than the CDC FIFO
+ * are written in chunks, since each full FIFO gets flushed into the endpoint buffer as it's written.
+ * @param bytes The framed packet
+ * @param length The length of the framed packet
  */
-void SegaSlider::send_packet(SliderPacket* packet) {
-    uint8_t checksum = 0;
-
-    tud_cdc_n_write_char(ITF_SLIDER, SLIDER_PACKET_BEGIN);
-    checksum -= SLIDER_PACKET_BEGIN;
+void SegaSlider::send_frame(const uint8_t* bytes, uint8_t length) {
+    uint32_t written = 0;
 
-    send_escaped_byte(packet->command_id);
-    checksum -= packet->command_id;
+    while (written < length) {
+        uint32_t count = tud_cdc_n_write(ITF_SLIDER, bytes + written, length - written);
 
-    send_escaped_byte(packet->length);
-    checksum -= packet->length;
+        // The FIFO is full and the endpoint is still busy, so the rest of the frame is dropped
+        if (count == 0) {
+            break;
+        }
 
-    for (int i = 0; i < packet->length; i++) {
-        send_escaped_byte(packet->data[i]);
-        checksum -= (packet->data[i]);
+        written += count;
     }
 
-    send_escaped_byte(checksum);
-
     tud_cdc_n_write_flush(ITF_SLIDER);
 }
 
- /**
-  * @brief Sends a byte to the host, escaping it if necessary.
-  * @param byte The byte to send
-  */
-void SegaSlider::send_escaped_byte(uint8_t byte) {
-    if (byte == SLIDER_PACKET_BEGIN || byte == SLIDER_PACKET_ESCAPE) {
-        tud_cdc_n_write_char(ITF_SLIDER, SLIDER_PACKET_ESCAPE);
-        byte -= 1;
+/**
+ * @brief Handles a request from the main processor to send a slider report
+ * packet to the host. This copies the newest report published by the scanning
+ * core, retrying if that core re-used the buffer part-way through the copy.
+ */
+void SegaSlider::send_slider_report() {
+    uint32_t sequence;
+    uint8_t length;
+    uint32_t scan_time_us;
+
+    do {
+        sequence = report_sequence;
+        __dmb();
+
+        uint8_t index = sequence & 1;
+        length = report_frame_lengths[index];
+        scan_time_us = report_frame_times_us[index];
+        memcpy(frame_buffer, report_frames[index], length);
+
+        __dmb();
+    } while (report_sequence != sequence);
+
+    send_frame(frame_buffer, length);
+
+    // Keep track of how old the touch data was by the time it was sent
+    uint32_t age = time_us_32() - scan_time_us;
+    report_age_total_us += age;
+    report_count++;
+
+    if (age > report_age_max_us) {
+        report_age_max_us = age;
     }
-    
-    tud_cdc_n_write_char(ITF_SLIDER, byte);
 }
 
 /**
- * @brief Handles a request from the main processor to send a slider report
- * packet to the host.
+ * @brief Resets the slider report age statistics, called after they've been logged.
  */
-void SegaSlider::send_slider_report() {
-    send_packet(generate_slider_report());
+void SegaSlider::reset_report_stats() {
+    report_age_max_us = 0;
+    report_age_total_us = 0;
+    report_count = 0;
 }
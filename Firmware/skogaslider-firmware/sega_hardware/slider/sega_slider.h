@@ -8,9 +8,11 @@
 #pragma once
 
 #include <stdio.h>
+#include "hardware/sync.h"
 #include "tusb.h"
 #include "protocol.h"
 #include "../serial/sega_serial_reader.h"
+#include "../serial/sega_frame_encoder.h"
 #include "../../slider/touch_slider.h"
 #include "../../leds/led_controller.h"
 
@@ -21,32 +23,54 @@
 
 /**
  * @brief Class that implements the SEGA slider's request and response protocol.
+ *
+ * Slider reports are built ahead of time by the scanning core: at the end of every scan, build_slider_report()
+ * remaps, escapes and checksums the report into one of two frame buffers and publishes it by bumping a sequence
+ * number. Sending a report on the other core then only copies the newest published frame into the CDC FIFO.
  */
 class SegaSlider {
     private:
-        SliderPacket* response_packet;
         TouchSlider* touch_slider;
         LedController* led_strip;
         uint8_t slider_response_data[32];
-        uint8_t hw_info_response_data[18];
+        uint8_t frame_buffer[slider_frame_capacity(32)];
+        /** Double-buffered, fully framed slider reports built by the scanning core */
+        uint8_t report_frames[2][slider_frame_capacity(32)];
+        /** Lengths of the framed reports in report_frames */
+        uint8_t report_frame_lengths[2];
+        /** When the touch data in each of the framed reports was scanned */
+        uint32_t report_frame_times_us[2];
+        /** Sequence number of the newest published report, whose frame is report_frames[report_sequence & 1] */
+        volatile uint32_t report_sequence;
 
         uint8_t map_touch_to_byte(uint16_t value);
-        SliderPacket* generate_slider_report();
-        SliderPacket* handle_slider_report();
+        void handle_slider_report();
         void handle_led_report(SliderPacket* request);
         void handle_enable_slider_report();
-        SliderPacket* handle_disable_slider_report();
-        SliderPacket* handle_reset();
-        SliderPacket* handle_get_hw_info();
-        void send_packet(SliderPacket* packet);
-        void send_escaped_byte(uint8_t byte);
-        SliderPacket* handle_set_short_raw_count_offset();
-        SliderPacket* handle_set_short_raw_count_shift();
+        void handle_disable_slider_report();
+        void handle_reset();
+        void handle_get_hw_info();
+        void send_frame(const uint8_t* bytes, uint8_t length);
+        void handle_set_short_raw_count_offset();
+        void handle_set_short_raw_count_shift();
 
     public:
         bool auto_send_reports;
+        /** Oldest touch data sent in a slider report since the stats were last reset */
+        uint32_t report_age_max_us;
+        /** Sum of the ages of the touch data sent in slider reports since the stats were last reset */
+        uint32_t report_age_total_us;
+        /** How many slider reports were sent since the stats were last reset */
+        uint32_t report_count;
+        /**
+         * The touch slider's change count as of the newest published report. Report-on-change scheduling watches
+         * this rather than the slider's own change count, which moves before the report with the change is built.
+         */
+        volatile uint32_t published_change_count;
 
         SegaSlider(TouchSlider* _slider, LedController* _led_strip);
         void process_packet(SliderPacket* request);
+        void build_slider_report();
         void send_slider_report();
+        void reset_report_stats();
 };
@@ -0,0 +1,245 @@
+/**
+ * @file slider_report_scheduler.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-07
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include "slider_report_scheduler.h"
+
+/**
+ * @brief Construct a new SliderReportScheduler::SliderReportScheduler object, and start the report alarm.
+ * @param period_us How many microseconds to wait between reports
+ */
+SliderReportScheduler::SliderReportScheduler(uint32_t period_us):
+    interval_min_us { UINT32_MAX },
+    interval_max_us { 0 },
+    polling_clock { false },
+    timer_running { false },
+    next_due_us { 0 },
+    due { false },
+    period_us { 0 },
+    report_on_change { false },
+    heartbeat_us { 0 },
+    last_change_count { 0 },
+    last_due_us { 0 },
+    last_report_us { 0 },
+    bucket_width_us { 1 },
+    interval_histogram { 0 },
+    interval_count { 0 }
+{
+    set_period_us(period_us);
+}
+
+/**
+ * @brief Changes the period between reports, clamped to the supported range, and restarts the alarm.
+ * @param period_us How many microseconds to wait between reports
+ */
+void SliderReportScheduler::set_period_us(uint32_t period_us) {
+    if (period_us < SLIDER_REPORT_PERIOD_MIN_US) {
+        period_us = SLIDER_REPORT_PERIOD_MIN_US;
+    } else if (period_us > SLIDER_REPORT_PERIOD_MAX_US) {
+        period_us = SLIDER_REPORT_PERIOD_MAX_US;
+    }
+
+    stop_timer();
+    this->period_us = period_us;
+    report_on_change = false;
+    set_histogram_span(period_us * 2);
+    reset_interval();
+
+    // A negative delay means the alarm is rescheduled relative to when it was last due, rather than
+    // when the callback finished running, so the reports stay at a fixed rate
+    timer_running = add_repeating_timer_us(-((int64_t) period_us), on_alarm, this, &timer);
+
+    // If no alarm was free, report_due() checks the clock from the main loop instead, which is flagged in the logs
+    polling_clock = !timer_running;
+    next_due_us = time_us_32() + period_us;
+}
+
+/**
+ * @brief Stops the repeating alarm, if it's running.
+ */
+void SliderReportScheduler::stop_timer() {
+    if (timer_running) {
+        cancel_repeating_timer(&timer);
+        timer_running = false;
+    }
+
+    polling_clock = false;
+}
+
+/**
+ * @brief Sizes the interval histogram's buckets to cover the given span, and clears it.
+ * @param span_us The longest interval the histogram resolves, longer ones all go in the last bucket
+ */
+void SliderReportScheduler::set_histogram_span(uint32_t span_us) {
+    bucket_width_us = span_us / REPORT_INTERVAL_BUCKETS;
+
+    if (bucket_width_us == 0) {
+        bucket_width_us = 1;
+    }
+
+    reset_stats();
+}
+
+/**
+ * @brief Switches between report-on-change mode and sending reports at a fixed rate.
+ * @param enabled Whether to only send reports when the touch states change
+ * @param heartbeat_us In report-on-change mode, the longest time to go without sending a report
+ */
+void SliderReportScheduler::set_report_on_change(bool enabled, uint32_t heartbeat_us) {
+    if (enabled == report_on_change) {
+        if (enabled && heartbeat_us != this->heartbeat_us) {
+            this->heartbeat_us = heartbeat_us;
+            set_histogram_span(heartbeat_us * 2);
+        }
+
+        return;
+    }
+
+    if (enabled) {
+        // Changes are checked for in the main loop, so the fixed-rate alarm isn't needed. Every heartbeat is an
+        // interval too, so the histogram has to reach past them.
+        stop_timer();
+        due = false;
+        report_on_change = true;
+        this->heartbeat_us = heartbeat_us;
+        last_due_us = time_us_32();
+        set_histogram_span(heartbeat_us * 2);
+        reset_interval();
+    } else {
+        set_period_us(period_us);
+    }
+}
+
+/**
+ * @brief Says whether a report should be sent now. At a fixed rate, that's whenever the alarm has fired since
+ * the last call. In report-on-change mode, it's whenever the touch states have changed since the last report
+ * (but no sooner than one USB frame after it), or when the heartbeat is due.
+ * @param change_count The touch slider's change count as of the newest report that's ready to send, so a change
+ * is only seen once a report with it can be sent
+ */
+bool SliderReportScheduler::report_due(uint32_t change_count) {
+    if (report_on_change) {
+        uint32_t time_now = time_us_32();
+        uint32_t since_last = time_now - last_due_us;
+
+        if ((change_count != last_change_count && since_last >= USB_FRAME_US) || since_last >= heartbeat_us) {
+            last_change_count = change_count;
+            last_due_us = time_now;
+            return true;
+        }
+
+        return false;
+    }
+
+    if (polling_clock) {
+        uint32_t time_now = time_us_32();
+
+        if ((int32_t) (time_now - next_due_us) < 0) {
+            return false;
+        }
+
+        // Stay on the fixed schedule, unless the main loop fell a whole period behind, in which case start over from
+        // now rather than sending a burst of reports to catch up
+        next_due_us += period_us;
+
+        if ((int32_t) (time_now - next_due_us) >= 0) {
+            next_due_us = time_now + period_us;
+        }
+
+        return true;
+    }
+
+    if (!due) {
+        return false;
+    }
+
+    due = false;
+    return true;
+}
+
+/**
+ * @brief Records that a report was just sent, adding the interval since the previous one to the statistics.
+ */
+void SliderReportScheduler::record_report() {
+    uint32_t time_now = time_us_32();
+
+    if (last_report_us != 0) {
+        uint32_t interval = time_now - last_report_us;
+        uint32_t bucket = interval / bucket_width_us;
+
+        if (bucket >= REPORT_INTERVAL_BUCKETS) {
+            bucket = REPORT_INTERVAL_BUCKETS - 1;
+        }
+
+        interval_histogram[bucket]++;
+        interval_count++;
+
+        if (interval < interval_min_us) {
+            interval_min_us = interval;
+        }
+
+        if (interval > interval_max_us) {
+            interval_max_us = interval;
+        }
+    }
+
+    // Avoid the 0 sentinel if the timer happens to wrap onto it
+    last_report_us = time_now == 0 ? 1 : time_now;
+}
+
+/**
+ * @brief Marks that reports have stopped, so the gap until they start again isn't counted as an interval.
+ */
+void SliderReportScheduler::reset_interval() {
+    last_report_us = 0;
+}
+
+/**
+ * @brief Returns the given percentile of the recorded intervals, rounded up to the histogram's resolution. If it
+ * lands in the last bucket, which also holds every interval past the histogram's span, the longest interval is
+ * returned instead, since the bucket's own bound would understate it.
+ * @param percentile The percentile to return (e.g. 99)
+ */
+uint32_t SliderReportScheduler::interval_percentile_us(uint8_t percentile) {
+    uint32_t target = ((interval_count * percentile) + 99) / 100;
+    uint32_t seen = 0;
+
+    if (interval_count == 0) {
+        return 0;
+    }
+
+    for (uint8_t bucket = 0; bucket < REPORT_INTERVAL_BUCKETS; bucket++) {
+        seen += interval_histogram[bucket];
+
+        if (seen >= target) {
+            return bucket == REPORT_INTERVAL_BUCKETS - 1 ? interval_max_us : (bucket + 1) * bucket_width_us;
+        }
+    }
+
+    return interval_max_us;
+}
+
+/**
+ * @brief Resets the interval statistics, called after they've been logged.
+ */
+void SliderReportScheduler::reset_stats() {
+    for (uint8_t bucket = 0; bucket < REPORT_INTERVAL_BUCKETS; bucket++) {
+        interval_histogram[bucket] = 0;
+    }
+
+    interval_count = 0;
+    interval_min_us = UINT32_MAX;
+    interval_max_us = 0;
+}
+
+/**
+ * @brief Alarm callback, runs in the timer IRQ and just flags that a report is due. The report itself is
+ * sent from the main loop, since TinyUSB can't be called from interrupt context.
+ */
+bool SliderReportScheduler::on_alarm(repeating_timer_t* rt) {
+    ((SliderReportScheduler*) rt->user_data)->due = true;
+    return true;
+}
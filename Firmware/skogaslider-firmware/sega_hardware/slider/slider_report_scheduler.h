@@ -0,0 +1,86 @@
+/**
+ * @file slider_report_scheduler.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-07
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+/** Shortest allowed period between automatic slider reports (one USB frame) */
+#define SLIDER_REPORT_PERIOD_MIN_US 1000
+/** Longest allowed period between automatic slider reports (slower than a real slider) */
+#define SLIDER_REPORT_PERIOD_MAX_US 16000
+/**
+ * How many buckets the inter-report interval histogram has, spanning zero to twice the report period (or twice the
+ * heartbeat period in report-on-change mode)
+ */
+#define REPORT_INTERVAL_BUCKETS 64
+/** Length of a full-speed USB frame, the shortest gap allowed between reports in report-on-change mode */
+#define USB_FRAME_US 1000
+
+/**
+ * @brief Paces the automatic slider reports in arcade mode. A repeating hardware alarm fires at a fixed rate with
+ * microsecond resolution (it's scheduled from the previous alarm, not from when the report was sent, so it doesn't
+ * drift), and the main loop sends a report whenever it sees that the alarm has fired. The actual intervals between
+ * reports that were sent are recorded, so the jitter can be checked.
+ *
+ * Alternatively, in report-on-change mode, a report is due as soon as the touch states change (at most once per
+ * USB frame), and otherwise only a low-rate heartbeat is sent so the host doesn't time the slider out.
+ */
+class SliderReportScheduler {
+    public:
+        /** Shortest interval between two sent reports since the stats were last reset */
+        uint32_t interval_min_us;
+        /** Longest interval between two sent reports since the stats were last reset */
+        uint32_t interval_max_us;
+        /**
+         * Whether the repeating alarm couldn't be added (the alarm pool is shared with the LED strips), so reports
+         * at a fixed rate are paced by report_due() checking the clock instead
+         */
+        bool polling_clock;
+
+        SliderReportScheduler(uint32_t period_us);
+        void set_period_us(uint32_t period_us);
+        void set_report_on_change(bool enabled, uint32_t heartbeat_us);
+        bool report_due(uint32_t change_count);
+        void record_report();
+        void reset_interval();
+        uint32_t interval_percentile_us(uint8_t percentile);
+        void reset_stats();
+
+    private:
+        /** The repeating alarm which flags when a report is due */
+        repeating_timer_t timer;
+        /** Whether the repeating alarm is currently running */
+        bool timer_running;
+        /** When polling the clock, when the next report is due */
+        uint32_t next_due_us;
+        /** Set by the alarm, and cleared once the main loop has seen it */
+        volatile bool due;
+        /** The period between reports */
+        uint32_t period_us;
+        /** Whether reports are sent when the touch states change, rather than at a fixed rate */
+        bool report_on_change;
+        /** In report-on-change mode, the longest time to go without sending a report */
+        uint32_t heartbeat_us;
+        /** In report-on-change mode, the touch change count that was last reported */
+        uint32_t last_change_count;
+        /** In report-on-change mode, when a report was last due */
+        uint32_t last_due_us;
+        /** When the last report was sent, or 0 if the next report starts a new run of reports */
+        uint32_t last_report_us;
+        /** Width of each bucket in the interval histogram */
+        uint32_t bucket_width_us;
+        /** Histogram of the intervals between sent reports */
+        uint32_t interval_histogram[REPORT_INTERVAL_BUCKETS];
+        /** How many intervals are recorded in the histogram */
+        uint32_t interval_count;
+
+        void stop_timer();
+        void set_histogram_span(uint32_t span_us);
+
+        static bool on_alarm(repeating_timer_t* rt);
+};
@@ -0,0 +1,33 @@
+/**
+ * @file slider_responses.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief The slider's constant responses, fully framed at compile time. These live in their own header so the host
+ * tests can check them against the runtime encoder.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "protocol.h"
+#include "../serial/sega_frame_encoder.h"
+
+/** Hardware information reported by the slider, copied from a real 15330 board */
+static constexpr uint8_t hw_info_response_data[18] = {
+    0x31, 0x35, 0x33, 0x33, 0x30, 0x20, 0x20, 0x20,
+    0xA0, 0x30, 0x36, 0x37, 0x31, 0x32, 0xFF, 0x90,
+    0x00, 0x64
+};
+
+// Constant responses, fully framed at compile time so they can be sent with a single write
+static constexpr auto hw_info_response = make_slider_frame(GET_HW_INFO, hw_info_response_data);
+static constexpr auto disable_slider_report_ack = make_slider_frame(DISABLE_SLIDER_REPORT);
+static constexpr auto slider_reset_ack = make_slider_frame(SLIDER_RESET);
+static constexpr auto set_short_raw_count_offset_ack = make_slider_frame(SET_SHORT_RAW_COUNT_OFFSET);
+static constexpr auto set_short_raw_count_shift_ack = make_slider_frame(SET_SHORT_RAW_COUNT_SHIFT);
+
+// Sanity check the encoder against a hand-framed ACK, whose checksum (0xFD) needs escaping
+static_assert(disable_slider_report_ack.length == 5, "Unexpected DISABLE_SLIDER_REPORT ACK length");
+static_assert(disable_slider_report_ack.bytes[0] == 0xFF && disable_slider_report_ack.bytes[1] == 0x04
+    && disable_slider_report_ack.bytes[2] == 0x00 && disable_slider_report_ack.bytes[3] == 0xFD
+    && disable_slider_report_ack.bytes[4] == 0xFC, "Unexpected DISABLE_SLIDER_REPORT ACK framing");
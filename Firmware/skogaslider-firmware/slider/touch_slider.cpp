@@ -16,7 +16,9 @@ TouchSlider::TouchSlider():
         MPR121(i2c0, I2C_ADDR_MPR121_1),
         MPR121(i2c0, I2C_ADDR_MPR121_2)
     },
-    states { false }
+    states { false },
+    change_count { 0 },
+    last_touched { 0 }
 {
 }
 
@@ -27,25 +29,25 @@ TouchSlider::TouchSlider():
  * @return bool* The boolean touch state of each sensor
  */
 bool* TouchSlider::scan_touch_states() {
-    uint8_t curr_state_index = 0;
+    uint16_t touched[3];
 
-    // Loop over the 3 MPR121s and read every key
+    // Read all 3 MPR121s, then put their electrodes in key order. The 3rd MPR121 only contains 8 keys, so its last
+    // 4 electrodes are dropped.
     for (uint8_t sensor_index = 0; sensor_index < 3; sensor_index++) {
         MPR121 mpr121 = touch_sensors[sensor_index];
-        uint16_t touched = mpr121.get_all_touched();
-        uint8_t lower_bound;
-        
-        // The 3rd MPR121 only contains 8 keys, so we make sure not to read the last 4 electrodes
-        // on this sensor.
-        if (sensor_index == 2) {
-            lower_bound = 4;
-        } else {
-            lower_bound = 0;
-        }
+        touched[sensor_index] = mpr121.get_all_touched();
+    }
 
-        for (int i = 11; i >= lower_bound; i--) {
-            states[curr_state_index++] = bit_read(touched, i);
-        }
+    uint32_t touched_bits = pack_touch_bits(touched);
+
+    for (uint8_t i = 0; i < 32; i++) {
+        states[i] = bit_read(touched_bits, i);
+    }
+
+    // Let anyone watching know that the touch frame is different from the last scan
+    if (touched_bits != last_touched) {
+        last_touched = touched_bits;
+        change_count = change_count + 1;
     }
 
     return states;
@@ -89,3 +91,19 @@ uint16_t* TouchSlider::scan_touch_readouts() {
 bool TouchSlider::is_key_pressed(uint8_t key) {
     return states[key * 2] | states[key * 2 + 1];
 }
+
+/**
+ * @brief Returns the pressed status of every key, checking both sensors for each key.
+ * @return uint16_t One bit per key, with key 0 in the lowest bit
+ */
+uint16_t TouchSlider::get_pressed_keys() {
+    uint16_t pressed_keys = 0;
+
+    for (uint8_t key = 0; key < 16; key++) {
+        if (is_key_pressed(key)) {
+            pressed_keys |= 1 << key;
+        }
+    }
+
+    return pressed_keys;
+}
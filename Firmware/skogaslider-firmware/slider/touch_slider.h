@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include "../config.h"
 #include "mpr121/mpr121.h"
+#include "../perf/interp_kernels.h"
 
 #define I2C_ADDR_MPR121_0 0x5A
 #define I2C_ADDR_MPR121_1 0x5C
@@ -24,13 +25,18 @@
 class TouchSlider {
     private:
         MPR121 touch_sensors[3];
+        /** Bitfield of the touch states from the last scan, one bit per sensor */
+        uint32_t last_touched;
 
     public:
         bool states[32];
         uint16_t touch_readouts[32];
+        /** Incremented by the scanning core every time the touch states change, so other code can cheaply detect changes */
+        volatile uint32_t change_count;
 
         TouchSlider();
         bool* scan_touch_states();
         uint16_t* scan_touch_readouts();
         bool is_key_pressed(uint8_t key);
+        uint16_t get_pressed_keys();
 };
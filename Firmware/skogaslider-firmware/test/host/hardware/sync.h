@@ -0,0 +1,17 @@
+/**
+ * @file sync.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Host stand-in for the Pico SDK's hardware/sync.h, for the host tests. The memory barrier becomes a full
+ * fence, so code built on it can be run from two host threads the way it runs on the two cores.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include <atomic>
+#include "../pico.h"
+
+static inline void __dmb() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
@@ -0,0 +1,18 @@
+/**
+ * @file pico.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Host stand-in for the Pico SDK's base header, with just enough for the hardware-independent firmware headers
+ * to build in the host tests.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define __packed __attribute__((packed))
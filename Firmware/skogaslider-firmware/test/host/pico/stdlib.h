@@ -0,0 +1,48 @@
+/**
+ * @file stdlib.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Host stand-in for the Pico SDK's pico/stdlib.h, for the host tests. The clock only moves when a test sets
+ * host_time_us, and repeating timers never fire on their own: a test fires one by calling its callback, and can make
+ * adding one fail with host_alarms_free.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "../pico.h"
+
+/** The current time as seen by the code under test */
+inline uint32_t host_time_us = 0;
+/** Whether add_repeating_timer_us() succeeds, as if the alarm pool had a free slot */
+inline bool host_alarms_free = true;
+
+static inline uint32_t time_us_32() {
+    return host_time_us;
+}
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t* rt);
+
+struct repeating_timer {
+    int64_t delay_us;
+    repeating_timer_callback_t callback;
+    void* user_data;
+};
+
+static inline bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data,
+    repeating_timer_t* out) {
+    if (!host_alarms_free) {
+        return false;
+    }
+
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    return true;
+}
+
+static inline bool cancel_repeating_timer(repeating_timer_t* timer) {
+    timer->callback = NULL;
+    return true;
+}
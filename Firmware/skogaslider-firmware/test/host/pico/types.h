@@ -0,0 +1,11 @@
+/**
+ * @file types.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Host stand-in for the Pico SDK's pico/types.h, for the host tests.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include "../pico.h"
@@ -0,0 +1,196 @@
+/**
+ * @file test_fixed_color_math.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks that PicoLed's Q16 fixed-point color math (MixColorsFixed and the *Fixed fades) gives the same colors
+ * as the double versions to within 1 step per channel, and that ratios past 1.0 are clamped.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdlib.h>
+#include <memory>
+#include "PicoLedColor.hpp"
+#include "PicoLedController.hpp"
+#include "test_helpers.h"
+
+using namespace PicoLed;
+
+/** The length of the strips the fades are tested on, the same as the controller's */
+#define NUM_LEDS 65
+
+/**
+ * @brief A target that keeps its pixels in memory, so the controllers can be run without any LEDs.
+ */
+class MemoryTarget: public PicoLedTarget {
+    public:
+        uint32_t pixels[NUM_LEDS];
+
+        MemoryTarget(): PicoLedTarget(NUM_LEDS, RED, GREEN, BLUE, WHITE), pixels() {}
+
+        uint32_t getData(uint index) override {
+            return index < NUM_LEDS ? pixels[index] : 0;
+        }
+
+        void setData(uint index, uint32_t value) override {
+            if (index < NUM_LEDS) {
+                pixels[index] = value;
+            }
+        }
+};
+
+/**
+ * @brief Returns the largest difference between any channel of the two colors.
+ */
+static int color_distance(Color a, Color b) {
+    int distance = abs(a.red - b.red);
+    distance = std::max(distance, abs(a.green - b.green));
+    distance = std::max(distance, abs(a.blue - b.blue));
+    return std::max(distance, abs(a.white - b.white));
+}
+
+static Color random_color() {
+    return RGBW(rand(), rand(), rand(), rand());
+}
+
+/**
+ * @brief A controller along with the target it draws into, so its pixels can be read back.
+ */
+struct Strip {
+    shared_ptr<MemoryTarget> target;
+    PicoLedController controller;
+
+    Strip(): target(std::make_shared<MemoryTarget>()), controller(target) {}
+};
+
+/**
+ * @brief Fills both strips with the same random pixels.
+ */
+static void randomize(Strip& a, Strip& b) {
+    for (uint i = 0; i < NUM_LEDS; i++) {
+        Color color = random_color();
+        a.target->setPixelColor(i, color);
+        b.target->setPixelColor(i, color);
+    }
+}
+
+/**
+ * @brief Checks that every pixel of the two strips is within 1 step of the other.
+ */
+static void check_strips(const char* name, Strip& expected, Strip& actual, int round) {
+    for (uint i = 0; i < NUM_LEDS; i++) {
+        Color a = expected.target->getPixelColor(i);
+        Color b = actual.target->getPixelColor(i);
+        CHECK(color_distance(a, b) <= 1, "%s round %d pixel %u: %u,%u,%u,%u vs %u,%u,%u,%u", name, round, i,
+            a.red, a.green, a.blue, a.white, b.red, b.green, b.blue, b.white);
+    }
+}
+
+/**
+ * @brief MixColorsFixed against MixColors, for every pair of channel values at a spread of ratios.
+ */
+static void test_mix_colors() {
+    for (int step = 0; step <= 64; step++) {
+        double ratio = step / 64.0 - (step % 3) * 0.0037;
+        ratio = ratio < 0.0 ? 0.0 : ratio;
+
+        for (int a = 0; a < 256; a++) {
+            for (int b = 0; b < 256; b++) {
+                Color colorA = RGBW(a, b, a, b);
+                Color colorB = RGBW(b, a, 255 - a, 255 - b);
+                Color expected = MixColors(colorA, colorB, ratio);
+                Color actual = MixColorsFixed(colorA, colorB, toFixed(ratio));
+                CHECK(color_distance(expected, actual) <= 1, "MixColors %d/%d at %f", a, b, ratio);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Ratios past 1.0 give colorA, instead of wrapping around.
+ */
+static void test_mix_colors_clamp() {
+    const uint32_t ratios[] = { FIXED_ONE + 1, FIXED_ONE * 2, FIXED_ONE * 1000, UINT32_MAX };
+
+    for (uint32_t ratio : ratios) {
+        Color colorA = RGBW(200, 10, 255, 128);
+        Color colorB = RGBW(5, 250, 0, 64);
+        CHECK(color_distance(MixColorsFixed(colorA, colorB, ratio), colorA) == 0, "MixColorsFixed at ratio %u", ratio);
+    }
+}
+
+/**
+ * @brief The fixed-point fades against the double ones, on identical strips, in both set and add mode.
+ */
+static void test_fades() {
+    Strip expected;
+    Strip actual;
+
+    for (int round = 0; round < 2000; round++) {
+        DrawMode mode = round % 4 == 3 ? MODE_ADD : MODE_SET;
+        expected.controller.setDrawMode(mode);
+        actual.controller.setDrawMode(mode);
+        Color color = random_color();
+        double factor = (rand() % 1001) / 1000.0;
+
+        // Whole strip and partial fades
+        randomize(expected, actual);
+        uint first = rand() % NUM_LEDS;
+        uint count = rand() % (NUM_LEDS + 1);
+        expected.controller.fade(color, first, count, factor);
+        actual.controller.fadeFixed(color, first, count, toFixed(factor));
+        check_strips("fade", expected, actual, round);
+
+        // Single pixels
+        randomize(expected, actual);
+        expected.controller.fadePixel(first, color, factor);
+        actual.controller.fadePixelFixed(first, color, toFixed(factor));
+        check_strips("fadePixel", expected, actual, round);
+
+        // Lines with fractional ends, on positions that are exact in both formats (1/256ths of a pixel)
+        randomize(expected, actual);
+        int32_t lineFirst = (rand() % (80 * 256)) - (5 * 256);
+        int32_t lineCount = rand() % (30 * 256);
+        expected.controller.fadeLine(color, lineFirst / 256.0, lineCount / 256.0, factor);
+        actual.controller.fadeLineFixed(color, lineFirst << 8, lineCount << 8, toFixed(factor));
+        check_strips("fadeLine", expected, actual, round);
+    }
+}
+
+/**
+ * @brief fillGradient (which uses the fixed-point mix) against a gradient worked out with doubles.
+ */
+static void test_gradient() {
+    Strip actual;
+
+    for (int round = 0; round < 2000; round++) {
+        Color start = random_color();
+        Color end = random_color();
+        uint first = rand() % NUM_LEDS;
+        uint count = 1 + rand() % NUM_LEDS;
+        uint last = std::min(first + count, (uint) NUM_LEDS);
+
+        actual.controller.fillGradient(start, end, first, count);
+
+        for (uint i = first; i < last; i++) {
+            Color expected = MixColors(start, end, (double) (i - first) / (last - first));
+            CHECK(color_distance(expected, actual.target->getPixelColor(i)) <= 1, "fillGradient round %d pixel %u", round, i);
+        }
+    }
+}
+
+int main() {
+    srand(1);
+
+    // The in-memory strip has to give back exactly what it was given, or nothing else here means anything
+    Strip strip;
+    Color color = RGBW(1, 2, 254, 255);
+    strip.controller.setPixelColor(3, color);
+    CHECK(color_distance(strip.target->getPixelColor(3), color) == 0, "pixels don't round trip through the target");
+
+    test_mix_colors();
+    test_mix_colors_clamp();
+    test_fades();
+    test_gradient();
+
+    return test_result("test_fixed_color_math");
+}
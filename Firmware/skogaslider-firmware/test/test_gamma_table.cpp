@@ -0,0 +1,140 @@
+/**
+ * @file test_gamma_table.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks PicoLed's compile-time gamma table against pow(), and the combined brightness and gamma table the
+ * strips scale pixels with against the linear scalePixelData() it replaced. Also times the two write paths against
+ * each other on the host; the on-board numbers come from BENCHMARK_LED_MATH in main.cpp.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include "PicoLedGamma.hpp"
+#include "PicoLedTarget.hpp"
+#include "test_helpers.h"
+
+using namespace PicoLed;
+
+/** How many pixels are scaled per frame in the benchmark, the length of the full slider strip */
+#define BENCHMARK_LEDS 65
+/** How many frames the benchmark scales with each path */
+#define BENCHMARK_FRAMES 200000
+
+/**
+ * @brief Makes the target's linear scaling reachable from the test.
+ */
+class LinearScaler: public PicoLedTarget {
+    public:
+        LinearScaler(): PicoLedTarget(BENCHMARK_LEDS, GREEN, RED, BLUE, NONE) {}
+        using PicoLedTarget::scalePixelData;
+};
+
+/**
+ * @brief Every entry of a gamma table against pow(), rounded the same way.
+ */
+static void check_gamma_table(const char* name, const Gamma::Table& table, double gamma) {
+    for (int i = 0; i < 256; i++) {
+        int expected = (int) lround(pow(i / 255.0, gamma) * 255.0);
+        CHECK(table[i] == expected, "%s: entry %d is %u, pow() gives %d", name, i, table[i], expected);
+    }
+}
+
+/**
+ * @brief Without gamma, the combined table gives exactly what scalePixelData() did for every brightness, and with it
+ * every channel is the gamma corrected value scaled by the brightness.
+ */
+static void test_scale_table() {
+    LinearScaler linear;
+    ScaleTable table;
+
+    for (int brightness = 0; brightness < 256; brightness++) {
+        for (int round = 0; round < 1000; round++) {
+            uint32_t value = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+
+            table.update(brightness, false);
+            CHECK(table.scale(value) == linear.scalePixelData(value, brightness),
+                "linear: 0x%08X at brightness %d", value, brightness);
+
+            table.update(brightness, true);
+            uint32_t scaled = table.scale(value);
+
+            for (int shift = 0; shift < 32; shift += 8) {
+                uint8_t channel = (value >> shift) & 0xFF;
+                uint8_t expected = (Gamma::table[channel] * brightness + 127) / 255;
+                CHECK(((scaled >> shift) & 0xFF) == expected, "gamma: 0x%08X at brightness %d", value, brightness);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Times a write path over the same frame many times, and returns the nanoseconds it took per pixel.
+ */
+template<typename Scale>
+static double time_per_pixel(const uint32_t* pixels, uint32_t* wire, Scale scale) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        for (int i = 0; i < BENCHMARK_LEDS; i++) {
+            wire[i] = scale(pixels[i] ^ frame);
+        }
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ((double) BENCHMARK_FRAMES * BENCHMARK_LEDS);
+}
+
+/** Where the benchmark leaves its results, so the compiler can't drop the work */
+static volatile uint32_t benchmark_sink;
+
+/**
+ * @brief Prints the per-pixel cost of the linear scalePixelData() path, of that path with gamma correction done per
+ * channel in front of it (what gamma would have cost without the combined table), and of the combined table.
+ * Host timings only show the relative cost; they aren't checked, since they depend on the machine running the tests.
+ */
+static void benchmark_write_paths() {
+    static LinearScaler linear;
+    static ScaleTable table;
+    static uint32_t pixels[BENCHMARK_LEDS];
+    uint32_t wire[BENCHMARK_LEDS];
+
+    for (int i = 0; i < BENCHMARK_LEDS; i++) {
+        pixels[i] = i * 0x01030507;
+    }
+
+    table.update(200, true);
+
+    double linearNs = time_per_pixel(pixels, wire, [](uint32_t value) {
+        return linear.scalePixelData(value, 200);
+    });
+    benchmark_sink = wire[BENCHMARK_LEDS - 1];
+
+    double linearGammaNs = time_per_pixel(pixels, wire, [](uint32_t value) {
+        uint32_t corrected = (Gamma::table[value >> 24] << 24) | (Gamma::table[(value >> 16) & 0xFF] << 16)
+            | (Gamma::table[(value >> 8) & 0xFF] << 8) | Gamma::table[value & 0xFF];
+        return linear.scalePixelData(corrected, 200);
+    });
+    benchmark_sink = wire[BENCHMARK_LEDS - 1];
+
+    double tableNs = time_per_pixel(pixels, wire, [](uint32_t value) {
+        return table.scale(value);
+    });
+    benchmark_sink = wire[BENCHMARK_LEDS - 1];
+
+    printf("Scale %u LEDs: scalePixelData %.2f ns/pixel | gamma then scalePixelData %.2f ns/pixel | "
+        "combined table %.2f ns/pixel\n", BENCHMARK_LEDS, linearNs, linearGammaNs, tableNs);
+}
+
+int main() {
+    srand(1);
+
+    check_gamma_table("PICOLED_GAMMA", Gamma::table, PICOLED_GAMMA);
+    check_gamma_table("gamma 2.2", Gamma::Table(2.2), 2.2);
+    check_gamma_table("gamma 1.8", Gamma::Table(1.8), 1.8);
+    test_scale_table();
+    benchmark_write_paths();
+
+    return test_result("test_gamma_table");
+}
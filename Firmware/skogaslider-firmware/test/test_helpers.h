@@ -0,0 +1,108 @@
+/**
+ * @file test_helpers.h
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Minimal checks for the host tests. Failed checks are printed and counted, and test_result() turns the count
+ * into the exit code CTest looks at. Also has the byte-at-a-time reference framing shared by the serial frame tests.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+static int test_failures = 0;
+
+#define CHECK(condition, ...)                                                   \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            printf("%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            printf(__VA_ARGS__);                                                \
+            printf("\n");                                                       \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+/**
+ * @brief How a serial protocol checksums its frames.
+ */
+enum ChecksumRule {
+    /** The checksum is whatever makes every byte of the frame, SYNC included, sum to zero (the slider) */
+    CHECKSUM_ZERO_SUM_WITH_SYNC,
+    /** The checksum is the sum of every byte after SYNC (the LED boards) */
+    CHECKSUM_SUM_AFTER_SYNC
+};
+
+/**
+ * @brief The framing rules of a serial protocol: its SYNC and escape bytes, and its checksum.
+ */
+struct FrameRules {
+    uint8_t sync;
+    uint8_t escape;
+    ChecksumRule checksum;
+};
+
+/**
+ * @brief Appends a byte to the frame, escaping it if it's SYNC or the escape byte.
+ */
+static inline void reference_escaped_byte(const FrameRules& rules, std::vector<uint8_t>& out, uint8_t byte) {
+    if (byte == rules.sync || byte == rules.escape) {
+        out.push_back(rules.escape);
+        byte -= 1;
+    }
+
+    out.push_back(byte);
+}
+
+/**
+ * @brief Frames a packet one byte at a time, the way the runtime send paths did before frames were pre-encoded.
+ * @param body Every byte between SYNC and the checksum, unescaped
+ */
+static inline std::vector<uint8_t> reference_frame(const FrameRules& rules, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> out;
+    uint8_t checksum = rules.checksum == CHECKSUM_ZERO_SUM_WITH_SYNC ? -rules.sync : 0;
+
+    out.push_back(rules.sync);
+
+    for (uint8_t byte : body) {
+        reference_escaped_byte(rules, out, byte);
+        checksum = rules.checksum == CHECKSUM_ZERO_SUM_WITH_SYNC ? checksum - byte : checksum + byte;
+    }
+
+    reference_escaped_byte(rules, out, checksum);
+    return out;
+}
+
+/**
+ * @brief Checks a framed packet byte for byte against the reference framing of the same body, and that SYNC only
+ * appears at the start.
+ */
+static inline void check_frame(const char* name, const FrameRules& rules, const uint8_t* bytes, uint8_t length,
+    const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> expected = reference_frame(rules, body);
+
+    CHECK(length == expected.size(), "%s: length %u, expected %zu", name, length, expected.size());
+
+    for (size_t i = 0; i < expected.size() && i < length; i++) {
+        CHECK(bytes[i] == expected[i], "%s: byte %zu is 0x%02X, expected 0x%02X", name, i, bytes[i], expected[i]);
+    }
+
+    for (uint8_t i = 1; i < length; i++) {
+        CHECK(bytes[i] != rules.sync, "%s: unescaped SYNC byte at %u", name, i);
+    }
+}
+
+/**
+ * @brief Prints a summary of the checks, and returns the exit code for the test.
+ */
+static inline int test_result(const char* name) {
+    if (test_failures == 0) {
+        printf("%s: all checks passed\n", name);
+        return 0;
+    }
+
+    printf("%s: %d checks failed\n", name, test_failures);
+    return 1;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file test_interp_kernels.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks the plain C versions of the interpolator kernels against the loops they replaced, on random inputs.
+ * The interpolator versions themselves only exist on the device, where interp_kernels_benchmark() runs both.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "perf/interp_kernels.h"
+#include "test_helpers.h"
+
+/** How many random inputs each kernel is checked on */
+#define RANDOM_ROUNDS 100000
+
+/**
+ * @brief The touch packing as TouchSlider::scan_touch_states did it: electrodes 11-0 of each MPR121, one bit at a
+ * time, skipping electrodes 3-0 of the third one.
+ */
+static uint32_t reference_touch_bits(const uint16_t* touched) {
+    uint8_t curr_state_index = 0;
+    uint32_t touched_bits = 0;
+
+    for (uint8_t sensor_index = 0; sensor_index < 3; sensor_index++) {
+        uint8_t lower_bound = sensor_index == 2 ? 4 : 0;
+
+        for (int i = 11; i >= lower_bound; i--) {
+            bool state = (touched[sensor_index] >> i) & 0x01;
+            touched_bits |= (uint32_t) state << curr_state_index++;
+        }
+    }
+
+    return touched_bits;
+}
+
+/**
+ * @brief The LED report decoding as LedController did it, one slot at a time.
+ */
+static void reference_blit(uint32_t* pixels, const uint8_t* brg, const LedSlot* slots, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t* triple = &brg[i * 3];
+        uint32_t word = (triple[2] << 24) | (triple[1] << 16) | (triple[0] << 8);
+
+        for (uint8_t led = 0; led < slots[i].count; led++) {
+            pixels[slots[i].first + led] = word;
+        }
+    }
+}
+
+/**
+ * @brief The blend as LedController did it, one channel at a time rather than two per multiply.
+ */
+static uint32_t reference_blend(uint32_t from, uint32_t to, uint16_t weight) {
+    uint32_t pixel = 0;
+
+    for (uint8_t shift = 8; shift < 32; shift += 8) {
+        uint32_t a = (from >> shift) & 0xFF;
+        uint32_t b = (to >> shift) & 0xFF;
+        pixel |= (((a * (256 - weight)) + (b * weight)) >> 8) << shift;
+    }
+
+    return pixel;
+}
+
+static uint32_t random_word() {
+    return ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+}
+
+static void test_pack_touch_bits() {
+    uint32_t failures = 0;
+
+    for (int round = 0; round < RANDOM_ROUNDS; round++) {
+        // The MPR121s only have 12 electrodes, but the upper bits mustn't leak into the result either
+        uint16_t touched[3] = { (uint16_t) rand(), (uint16_t) rand(), (uint16_t) rand() };
+
+        if (pack_touch_bits_scalar(touched) != reference_touch_bits(touched)) {
+            failures++;
+        }
+    }
+
+    CHECK(failures == 0, "%u of %u touch frames packed differently", failures, RANDOM_ROUNDS);
+
+    uint16_t first[3] = { 0x0800, 0, 0 };
+    uint16_t last[3] = { 0, 0, 0x0010 };
+    CHECK(pack_touch_bits_scalar(first) == 0x00000001, "electrode 11 of the first MPR121 isn't sensor 0");
+    CHECK(pack_touch_bits_scalar(last) == 0x80000000, "electrode 4 of the third MPR121 isn't sensor 31");
+}
+
+static void test_blit_brg_slots() {
+    uint8_t brg[NUM_SLIDER_LED_SLOTS * 3];
+    uint32_t pixels[NUM_RGB_LEDS];
+    uint32_t expected[NUM_RGB_LEDS];
+    uint32_t failures = 0;
+
+    for (int round = 0; round < RANDOM_ROUNDS / 100; round++) {
+        for (uint8_t i = 0; i < sizeof(brg); i++) {
+            brg[i] = rand();
+        }
+
+        for (uint8_t i = 0; i < NUM_RGB_LEDS; i++) {
+            pixels[i] = expected[i] = random_word();
+        }
+
+        blit_brg_slots_scalar(pixels, brg, led_map.slider_report, NUM_SLIDER_LED_SLOTS);
+        reference_blit(expected, brg, led_map.slider_report, NUM_SLIDER_LED_SLOTS);
+
+        for (uint8_t tower = 0; tower < NUM_TOWERS; tower++) {
+            const LedSlot* groups = &led_map.tower_groups[tower * NUM_TOWER_GROUPS];
+            blit_brg_slots_scalar(pixels, &brg[tower * NUM_TOWER_GROUPS * 3], groups, NUM_TOWER_GROUPS);
+            reference_blit(expected, &brg[tower * NUM_TOWER_GROUPS * 3], groups, NUM_TOWER_GROUPS);
+        }
+
+        // LEDs outside the slots have to be left alone as well
+        if (memcmp(pixels, expected, sizeof(pixels)) != 0) {
+            failures++;
+        }
+    }
+
+    CHECK(failures == 0, "%u of %u LED reports decoded differently", failures, RANDOM_ROUNDS / 100);
+}
+
+static void test_blend_pixels() {
+    uint32_t from[NUM_RGB_LEDS];
+    uint32_t to[NUM_RGB_LEDS];
+    uint32_t pixels[NUM_RGB_LEDS];
+    uint32_t failures = 0;
+
+    for (int round = 0; round < RANDOM_ROUNDS / 100; round++) {
+        for (uint8_t i = 0; i < NUM_RGB_LEDS; i++) {
+            from[i] = random_word() & 0xFFFFFF00;
+            to[i] = random_word() & 0xFFFFFF00;
+        }
+
+        for (uint16_t weight = 0; weight <= 256; weight++) {
+            blend_pixels_scalar(pixels, from, to, NUM_RGB_LEDS, weight);
+
+            for (uint8_t i = 0; i < NUM_RGB_LEDS; i++) {
+                if (pixels[i] != reference_blend(from[i], to[i], weight)) {
+                    failures++;
+                }
+            }
+        }
+    }
+
+    CHECK(failures == 0, "%u pixels blended differently", failures);
+
+    blend_pixels_scalar(pixels, from, to, NUM_RGB_LEDS, 0);
+    CHECK(memcmp(pixels, from, sizeof(pixels)) == 0, "a weight of 0 isn't the first frame");
+    blend_pixels_scalar(pixels, from, to, NUM_RGB_LEDS, 256);
+    CHECK(memcmp(pixels, to, sizeof(pixels)) == 0, "a weight of 256 isn't the second frame");
+}
+
+int main() {
+    srand(0x5E6A);
+
+    test_pack_touch_bits();
+    test_blit_brg_slots();
+    test_blend_pixels();
+
+    return test_result("test_interp_kernels");
+}
@@ -0,0 +1,80 @@
+/**
+ * @file test_led_board_frames.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks the LED board responses pre-encoded at compile time, and the encoder itself, against the
+ * byte-at-a-time reference framing in test_helpers.h.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdlib.h>
+#include <vector>
+#include "sega_hardware/led_board/led_board_responses.h"
+// The slider's responses are only included to check that the two sets of names don't clash
+#include "sega_hardware/slider/slider_responses.h"
+#include "test_helpers.h"
+
+/** The LED boards' framing rules */
+static const FrameRules led_rules = { LED_PACKET_BEGIN, LED_PACKET_ESCAPE, CHECKSUM_SUM_AFTER_SYNC };
+
+/**
+ * @brief Checks a framed LED board response against the reference framing of its header and payload.
+ */
+static void check_led_frame(const char* name, const uint8_t* bytes, uint8_t length, uint8_t status, uint8_t command,
+    uint8_t report, const uint8_t* payload, uint8_t payload_length) {
+    std::vector<uint8_t> body = {
+        ADDRESS_HOST, ADDRESS_BOARD, (uint8_t) (payload_length + 3), status, command, report
+    };
+    body.insert(body.end(), payload, payload + payload_length);
+    check_frame(name, led_rules, bytes, length, body);
+}
+
+/**
+ * @brief Checks a pre-encoded constant response against the reference encoder. Constant responses are always sent
+ * with a status and report of 1.
+ */
+template <size_t Capacity>
+static void check_constant(const char* name, const EncodedFrame<Capacity>& frame, uint8_t command,
+    const uint8_t* payload, uint8_t payload_length) {
+    CHECK(frame.length <= Capacity, "%s: length %u overflows capacity %zu", name, frame.length, Capacity);
+    check_led_frame(name, frame.bytes, frame.length, 1, command, 1, payload, payload_length);
+}
+
+int main() {
+    // Every constant response the LED boards send
+    check_constant("BOARD_INFO", board_info_response, BOARD_INFO, board_info_payload, sizeof(board_info_payload));
+    check_constant("BOARD_STATUS", board_status_response, BOARD_STATUS, board_status_payload,
+        sizeof(board_status_payload));
+    check_constant("FW_SUM", fw_sum_response, FW_SUM, fw_sum_payload, sizeof(fw_sum_payload));
+    check_constant("PROTOCOL_VER", protocol_ver_response, PROTOCOL_VER, protocol_ver_payload,
+        sizeof(protocol_ver_payload));
+    check_constant("LED_RESET", led_reset_ack, LED_RESET, nullptr, 0);
+    check_constant("SET_LED", set_led_ack, SET_LED, nullptr, 0);
+
+    // The same encoder frames the dynamic responses at runtime, so check it on random payloads and headers too,
+    // weighted towards the bytes that need escaping
+    uint8_t buffer[led_frame_capacity(32)];
+    uint8_t payload[32];
+    srand(1);
+
+    for (int round = 0; round < 10000; round++) {
+        uint8_t length = rand() % 33;
+        uint8_t status = rand() % 2 ? LED_PACKET_ESCAPE : (uint8_t) rand();
+        uint8_t command = rand() % 2 ? LED_PACKET_BEGIN : (uint8_t) rand();
+
+        for (int i = 0; i < length; i++) {
+            int pick = rand() % 4;
+            payload[i] = pick == 0 ? LED_PACKET_BEGIN : pick == 1 ? LED_PACKET_ESCAPE : (uint8_t) rand();
+        }
+
+        uint8_t framed = encode_led_frame(buffer, status, command, 1, payload, length);
+        CHECK(framed <= led_frame_capacity(length), "random: length %u overflows capacity", framed);
+        check_led_frame("random", buffer, framed, status, command, 1, payload, length);
+
+        if (test_failures > 0) {
+            break;
+        }
+    }
+
+    return test_result("test_led_board_frames");
+}
@@ -0,0 +1,149 @@
+/**
+ * @file test_led_swap_chain.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks the LED swap chain's publish and take sequences and its frame counts, then runs a producer and a
+ * consumer on two threads to check that the consumer never sees a torn or out-of-order frame.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <thread>
+#include "leds/led_swap_chain.h"
+#include "test_helpers.h"
+
+/** How many frames the producer thread publishes in the stress test */
+#define STRESS_FRAMES 200000
+
+/**
+ * @brief Renders a frame with every pixel set to the same value, and publishes it.
+ */
+static void publish_value(LedSwapChain& chain, uint32_t value) {
+    LedFrame* frame = chain.back_frame();
+
+    for (uint i = 0; i < NUM_RGB_LEDS; i++) {
+        frame->pixels[i] = value;
+    }
+
+    chain.publish();
+}
+
+/**
+ * @brief Whether every pixel in the frame has the given value.
+ */
+static bool frame_is(const LedFrame* frame, uint32_t value) {
+    for (uint i = 0; i < NUM_RGB_LEDS; i++) {
+        if (frame->pixels[i] != value) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Nothing is taken until something is published, and each published frame is taken once.
+ */
+static void test_publish_take() {
+    LedSwapChain chain;
+    CHECK(chain.take_latest() == NULL, "a frame before anything was published");
+
+    publish_value(chain, 1);
+    const LedFrame* frame = chain.take_latest();
+    CHECK(frame != NULL && frame_is(frame, 1), "the published frame wasn't taken");
+    CHECK(chain.take_latest() == NULL, "the same frame was taken twice");
+
+    publish_value(chain, 2);
+    frame = chain.take_latest();
+    CHECK(frame != NULL && frame_is(frame, 2), "the second frame wasn't taken");
+    CHECK(chain.frames_published == 2 && chain.frames_replaced == 0, "published %u replaced %u",
+        chain.frames_published, chain.frames_replaced);
+}
+
+/**
+ * @brief Frames published before the consumer gets to them are replaced and counted, and only the newest is taken.
+ */
+static void test_replace() {
+    LedSwapChain chain;
+    publish_value(chain, 1);
+    publish_value(chain, 2);
+    publish_value(chain, 3);
+
+    const LedFrame* frame = chain.take_latest();
+    CHECK(frame != NULL && frame_is(frame, 3), "the newest frame wasn't taken");
+    CHECK(chain.take_latest() == NULL, "a replaced frame was taken");
+    CHECK(chain.frames_published == 3 && chain.frames_replaced == 2, "published %u replaced %u",
+        chain.frames_published, chain.frames_replaced);
+
+    chain.reset_stats();
+    CHECK(chain.frames_published == 0 && chain.frames_replaced == 0, "published %u replaced %u after a reset",
+        chain.frames_published, chain.frames_replaced);
+}
+
+/**
+ * @brief The producer never renders into the frame the consumer is reading, however often it publishes.
+ */
+static void test_reading_frame_kept() {
+    LedSwapChain chain;
+    publish_value(chain, 1);
+    const LedFrame* frame = chain.take_latest();
+
+    for (uint32_t value = 2; value < 10; value++) {
+        CHECK(chain.back_frame() != frame, "rendering into the frame being read at %u", value);
+        publish_value(chain, value);
+    }
+
+    CHECK(frame_is(frame, 1), "the frame being read was overwritten");
+    frame = chain.take_latest();
+    CHECK(frame != NULL && frame_is(frame, 9), "the newest frame wasn't taken after the others were replaced");
+    CHECK(chain.frames_replaced == 7, "replaced %u", chain.frames_replaced);
+}
+
+/**
+ * @brief Publishes and takes frames on two threads at once. Every taken frame has to be whole and newer than the one
+ * before it, and the consumer has to end up on the last frame.
+ */
+static void test_two_threads() {
+    static LedSwapChain chain;
+    uint32_t torn = 0;
+    uint32_t out_of_order = 0;
+    uint32_t taken = 0;
+    uint32_t last_value = 0;
+
+    std::thread producer([] {
+        for (uint32_t value = 1; value <= STRESS_FRAMES; value++) {
+            publish_value(chain, value);
+        }
+    });
+
+    while (last_value != STRESS_FRAMES) {
+        const LedFrame* frame = chain.take_latest();
+
+        if (frame == NULL) {
+            continue;
+        }
+
+        // Read the whole frame twice, so a producer writing into it in between shows up
+        uint32_t value = frame->pixels[0];
+        torn += !frame_is(frame, value);
+        torn += !frame_is(frame, value);
+        out_of_order += value <= last_value;
+        last_value = value;
+        taken++;
+    }
+
+    producer.join();
+
+    CHECK(torn == 0, "%u torn reads", torn);
+    CHECK(out_of_order == 0, "%u frames out of order", out_of_order);
+    CHECK(chain.frames_published == STRESS_FRAMES, "published %u", chain.frames_published);
+    CHECK(taken > 1, "only %u frames taken", taken);
+}
+
+int main() {
+    test_publish_take();
+    test_replace();
+    test_reading_frame_kept();
+    test_two_threads();
+
+    return test_result("test_led_swap_chain");
+}
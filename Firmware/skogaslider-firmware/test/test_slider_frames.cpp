@@ -0,0 +1,108 @@
+/**
+ * @file test_slider_frames.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks the slider frames pre-encoded at compile time, and the encoder itself, against the byte-at-a-time
+ * reference framing in test_helpers.h.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include <stdlib.h>
+#include <vector>
+#include "sega_hardware/slider/slider_responses.h"
+#include "test_helpers.h"
+
+/** The slider's framing rules */
+static const FrameRules slider_rules = { SLIDER_PACKET_BEGIN, SLIDER_PACKET_ESCAPE, CHECKSUM_ZERO_SUM_WITH_SYNC };
+
+/**
+ * @brief Checks a framed slider packet against the reference framing of its command, length and data.
+ */
+static void check_slider_frame(const char* name, const uint8_t* bytes, uint8_t length, uint8_t command_id,
+    const uint8_t* data, uint8_t data_length) {
+    std::vector<uint8_t> body = { command_id, data_length };
+    body.insert(body.end(), data, data + data_length);
+    check_frame(name, slider_rules, bytes, length, body);
+}
+
+/**
+ * @brief Unescapes a framed packet and checks that it decodes back to the same command, data and a valid checksum.
+ */
+static void check_round_trip(const char* name, const uint8_t* bytes, uint8_t length, uint8_t command_id,
+    const uint8_t* data, uint8_t data_length) {
+    std::vector<uint8_t> decoded;
+
+    CHECK(length > 0 && bytes[0] == SLIDER_PACKET_BEGIN, "%s: missing SYNC byte", name);
+
+    for (uint8_t i = 1; i < length; i++) {
+        if (bytes[i] == SLIDER_PACKET_ESCAPE && i + 1 < length) {
+            decoded.push_back(bytes[++i] + 1);
+        } else {
+            decoded.push_back(bytes[i]);
+        }
+    }
+
+    CHECK(decoded.size() == (size_t) data_length + 3, "%s: decoded %zu bytes", name, decoded.size());
+
+    if (decoded.size() != (size_t) data_length + 3) {
+        return;
+    }
+
+    uint8_t sum = SLIDER_PACKET_BEGIN;
+
+    for (uint8_t byte : decoded) {
+        sum += byte;
+    }
+
+    CHECK(sum == 0, "%s: checksum doesn't sum to zero (0x%02X)", name, sum);
+    CHECK(decoded[0] == command_id, "%s: command 0x%02X", name, decoded[0]);
+    CHECK(decoded[1] == data_length, "%s: length %u", name, decoded[1]);
+
+    for (uint8_t i = 0; i < data_length; i++) {
+        CHECK(decoded[2 + i] == data[i], "%s: data byte %u", name, i);
+    }
+}
+
+/**
+ * @brief Checks a pre-encoded constant response against the reference encoder.
+ */
+template <size_t Capacity>
+static void check_constant(const char* name, const EncodedFrame<Capacity>& frame, uint8_t command_id,
+    const uint8_t* data, uint8_t data_length) {
+    CHECK(frame.length <= Capacity, "%s: length %u overflows capacity %zu", name, frame.length, Capacity);
+    check_slider_frame(name, frame.bytes, frame.length, command_id, data, data_length);
+    check_round_trip(name, frame.bytes, frame.length, command_id, data, data_length);
+}
+
+int main() {
+    // Every constant response the slider sends
+    check_constant("GET_HW_INFO", hw_info_response, GET_HW_INFO, hw_info_response_data, sizeof(hw_info_response_data));
+    check_constant("DISABLE_SLIDER_REPORT", disable_slider_report_ack, DISABLE_SLIDER_REPORT, nullptr, 0);
+    check_constant("SLIDER_RESET", slider_reset_ack, SLIDER_RESET, nullptr, 0);
+    check_constant("SET_SHORT_RAW_COUNT_OFFSET", set_short_raw_count_offset_ack, SET_SHORT_RAW_COUNT_OFFSET, nullptr, 0);
+    check_constant("SET_SHORT_RAW_COUNT_SHIFT", set_short_raw_count_shift_ack, SET_SHORT_RAW_COUNT_SHIFT, nullptr, 0);
+
+    // The same encoder frames the slider reports at runtime, so check it on random reports too, weighted towards
+    // the bytes that need escaping
+    uint8_t buffer[slider_frame_capacity(32)];
+    uint8_t data[32];
+    srand(1);
+
+    for (int round = 0; round < 10000; round++) {
+        for (int i = 0; i < 32; i++) {
+            int pick = rand() % 4;
+            data[i] = pick == 0 ? SLIDER_PACKET_BEGIN : pick == 1 ? SLIDER_PACKET_ESCAPE : (uint8_t) rand();
+        }
+
+        uint8_t length = encode_slider_frame(buffer, SLIDER_REPORT, data, 32);
+        CHECK(length <= sizeof(buffer), "report: length %u overflows the buffer", length);
+        check_slider_frame("report", buffer, length, SLIDER_REPORT, data, 32);
+        check_round_trip("report", buffer, length, SLIDER_REPORT, data, 32);
+
+        if (test_failures > 0) {
+            break;
+        }
+    }
+
+    return test_result("test_slider_frames");
+}
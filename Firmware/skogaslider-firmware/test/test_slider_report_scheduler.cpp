@@ -0,0 +1,113 @@
+/**
+ * @file test_slider_report_scheduler.cpp
+ * @author skogaby <skogabyskogaby@gmail.com>
+ * @date 2022-08-22
+ * @brief Checks the slider report scheduler's interval statistics and its fallback for when no alarm is free, against
+ * a clock the test moves by hand.
+ * @copyright Copyright (c) skogaby 2022
+ */
+
+#include "sega_hardware/slider/slider_report_scheduler.h"
+#include "test_helpers.h"
+
+/**
+ * @brief Moves the clock on and records a report sent at the new time.
+ */
+static void report_after(SliderReportScheduler& scheduler, uint32_t interval_us) {
+    host_time_us += interval_us;
+    scheduler.record_report();
+}
+
+/**
+ * @brief At a fixed rate the percentiles come from the histogram, rounded up to a bucket.
+ */
+static void test_fixed_rate_percentile() {
+    SliderReportScheduler scheduler(4000);
+    scheduler.record_report();
+
+    for (int i = 0; i < 1000; i++) {
+        report_after(scheduler, 4000);
+    }
+
+    // 64 buckets over 8000us are 125us wide, and 4000us is the first value of the 33rd
+    CHECK(scheduler.interval_percentile_us(99) == 4125, "p99 %u", scheduler.interval_percentile_us(99));
+    CHECK(scheduler.interval_min_us == 4000 && scheduler.interval_max_us == 4000, "min %u max %u",
+        scheduler.interval_min_us, scheduler.interval_max_us);
+}
+
+/**
+ * @brief Intervals past the histogram's span all land in its last bucket, so a percentile there gives the longest
+ * interval rather than the bucket's bound.
+ */
+static void test_overflow_percentile() {
+    SliderReportScheduler scheduler(4000);
+    scheduler.record_report();
+
+    for (int i = 0; i < 10; i++) {
+        report_after(scheduler, 30000);
+    }
+
+    CHECK(scheduler.interval_percentile_us(99) == 30000, "p99 %u", scheduler.interval_percentile_us(99));
+}
+
+/**
+ * @brief In report-on-change mode the histogram reaches past the heartbeat, so a slider that nobody touches reads
+ * as the heartbeat, not as twice the fixed-rate period.
+ */
+static void test_heartbeat_percentile() {
+    SliderReportScheduler scheduler(4000);
+    scheduler.set_report_on_change(true, 50000);
+    scheduler.record_report();
+
+    for (int i = 0; i < 200; i++) {
+        report_after(scheduler, i % 2 ? 50000 : 1000);
+    }
+
+    uint32_t p99 = scheduler.interval_percentile_us(99);
+    CHECK(p99 >= 50000 && p99 < 50000 + 100000 / REPORT_INTERVAL_BUCKETS + 1, "p99 %u", p99);
+    CHECK(scheduler.interval_percentile_us(25) <= 1000 + 100000 / REPORT_INTERVAL_BUCKETS, "p25 %u",
+        scheduler.interval_percentile_us(25));
+}
+
+/**
+ * @brief With no alarm free, reports are still paced at the fixed rate by checking the clock, and a stall doesn't
+ * turn into a burst of catch-up reports.
+ */
+static void test_no_alarm_free() {
+    host_alarms_free = false;
+    host_time_us = 100000;
+    SliderReportScheduler scheduler(4000);
+    host_alarms_free = true;
+
+    CHECK(scheduler.polling_clock, "the missing alarm isn't flagged");
+    CHECK(!scheduler.report_due(0), "due straight away");
+
+    host_time_us += 3999;
+    CHECK(!scheduler.report_due(0), "due before a full period");
+
+    host_time_us += 1;
+    CHECK(scheduler.report_due(0), "not due after a full period");
+    CHECK(!scheduler.report_due(0), "due twice in one period");
+
+    host_time_us += 4000;
+    CHECK(scheduler.report_due(0), "not due after the second period");
+
+    host_time_us += 40000;
+    CHECK(scheduler.report_due(0), "not due after a stall");
+    CHECK(!scheduler.report_due(0), "catching up after a stall");
+
+    // Getting an alarm later stops the polling
+    scheduler.set_period_us(4000);
+    CHECK(!scheduler.polling_clock, "still polling with an alarm");
+}
+
+int main() {
+    host_time_us = 1000;
+
+    test_fixed_rate_percentile();
+    test_overflow_percentile();
+    test_heartbeat_percentile();
+    test_no_alarm_free();
+
+    return test_result("test_slider_report_scheduler");
+}
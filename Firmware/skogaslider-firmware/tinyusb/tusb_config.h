@@ -95,8 +95,17 @@ extern "C" {
 #define CFG_TUD_ENDPOINT0_SIZE 64
 #endif
 
+// Uncomment this to enumerate with the single configuration used before the
+// modes were split (the keyboard, all four serial ports and the IO4, in both
+// modes), so the enumeration time logged by main.cpp can be compared against it
+// #define USB_COMBINED_DESCRIPTOR_BASELINE
+
 //------------- CLASS -------------//
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+#define CFG_TUD_HID 2
+#else
 #define CFG_TUD_HID 1
+#endif
 #define CFG_TUD_CDC 4
 #define CFG_TUD_MSC 0
 #define CFG_TUD_MIDI 0
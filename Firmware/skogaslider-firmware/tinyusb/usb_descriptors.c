@@ -43,27 +43,75 @@
 //--------------------------------------------------------------------+
 // Device Descriptors
 //--------------------------------------------------------------------+
-tusb_desc_device_t const desc_device_key = {
-    .bLength = sizeof(tusb_desc_device_t),
-    .bDescriptorType = TUSB_DESC_DEVICE,
-    .bcdUSB = 0x0200,
-    .bDeviceClass = TUSB_CLASS_MISC,
-    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
-    .bDeviceProtocol = MISC_PROTOCOL_IAD,
-    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
-    .idVendor = 0x1337,
-    .idProduct = USB_PID,
-    .bcdDevice = 0x0100,
-    .iManufacturer = 0x01,
-    .iProduct = 0x02,
-    .iSerialNumber = 0x04,
-    .bNumConfigurations = 0x01
-};
+// The interfaces each mode enumerates with. The configuration descriptors and
+// product IDs below are generated from these.
+#define KEY_CDC_COUNT     1
+#define KEY_HID_COUNT     1
+#define ARCADE_CDC_COUNT  4
+#define ARCADE_HID_COUNT  1
+
+_Static_assert(KEY_CDC_COUNT <= CFG_TUD_CDC && ARCADE_CDC_COUNT <= CFG_TUD_CDC,
+               "CFG_TUD_CDC must cover the CDC interfaces of every mode");
+_Static_assert(KEY_HID_COUNT <= CFG_TUD_HID && ARCADE_HID_COUNT <= CFG_TUD_HID,
+               "CFG_TUD_HID must cover the HID interfaces of every mode");
+
+// Each mode has its own set of interfaces, so it also gets its own variant of
+// USB_PID, or the host would reuse the drivers it bound for the other mode.
+// The mode goes in the high byte, so no variant matches the PID of older
+// firmware, and the interface counts each get their own field:
+//   [15:8] 0x40 + mode + 1 | [7:4] HID count | [3:0] CDC count
+#define USB_PID_VARIANT(mode, cdc, hid) \
+  ((USB_PID & 0xFF00) | (((mode) + 1) << 8) | ((hid) << 4) | (cdc))
+
+_Static_assert(KEY_CDC_COUNT < 16 && ARCADE_CDC_COUNT < 16,
+               "CDC counts must fit in their 4-bit field of the PID");
+_Static_assert(KEY_HID_COUNT < 16 && ARCADE_HID_COUNT < 16,
+               "HID counts must fit in their 4-bit field of the PID");
+
+#define USB_PID_ARCADE \
+  USB_PID_VARIANT(OUTPUT_MODE_ARCADE, ARCADE_CDC_COUNT, ARCADE_HID_COUNT)
+#define USB_PID_KEYBOARD \
+  USB_PID_VARIANT(OUTPUT_MODE_KEYBOARD, KEY_CDC_COUNT, KEY_HID_COUNT)
+
+#define DEVICE_DESCRIPTOR(_pid)                        \
+  {                                                    \
+    .bLength = sizeof(tusb_desc_device_t),             \
+    .bDescriptorType = TUSB_DESC_DEVICE,               \
+    .bcdUSB = 0x0200,                                  \
+    .bDeviceClass = TUSB_CLASS_MISC,                   \
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,           \
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,              \
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,         \
+    .idVendor = 0x1337,                                \
+    .idProduct = (_pid),                               \
+    .bcdDevice = 0x0100,                               \
+    .iManufacturer = 0x01,                             \
+    .iProduct = 0x02,                                  \
+    .iSerialNumber = 0x04,                             \
+    .bNumConfigurations = 0x01                         \
+  }
+
+tusb_desc_device_t const desc_device_arcade = DEVICE_DESCRIPTOR(USB_PID_ARCADE);
+tusb_desc_device_t const desc_device_key = DEVICE_DESCRIPTOR(USB_PID_KEYBOARD);
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+// The combined configuration keeps the PID it had before the modes were split
+tusb_desc_device_t const desc_device_combined = DEVICE_DESCRIPTOR(USB_PID);
+#endif
+
+uint8_t usb_output_mode = OUTPUT_MODE_ARCADE;
 
 // Invoked when received GET DEVICE DESCRIPTOR
 // Application return pointer to descriptor
 uint8_t const* tud_descriptor_device_cb(void) {
-  return (uint8_t const*)(&desc_device_key);
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+  return (uint8_t const*)(&desc_device_combined);
+#endif
+
+  if (usb_output_mode == OUTPUT_MODE_KEYBOARD) {
+    return (uint8_t const*)(&desc_device_key);
+  }
+
+  return (uint8_t const*)(&desc_device_arcade);
 }
 
 //--------------------------------------------------------------------+
@@ -73,22 +121,57 @@ uint8_t const desc_hid_report_key[] = {
     GAMECON_REPORT_DESC_NKRO(HID_REPORT_ID(REPORT_ID_KEYBOARD))
 };
 
+// IO4 emulation: one input report for the switches, one for command
+// responses, and one output report for commands, 63 bytes each
+uint8_t const desc_hid_report_io4[] = {
+    HID_USAGE_PAGE_N(HID_USAGE_PAGE_VENDOR, 2), HID_USAGE(0x01),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+      HID_REPORT_ID(IO4_REPORT_ID_INPUT)
+      HID_USAGE(0x02), HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0xFF, 2),
+      HID_REPORT_SIZE(8), HID_REPORT_COUNT(IO4_REPORT_SIZE),
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+      HID_REPORT_ID(IO4_REPORT_ID_RESPONSE)
+      HID_USAGE(0x03), HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0xFF, 2),
+      HID_REPORT_SIZE(8), HID_REPORT_COUNT(IO4_REPORT_SIZE),
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+      HID_REPORT_ID(IO4_REPORT_ID_COMMAND)
+      HID_USAGE(0x04), HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0xFF, 2),
+      HID_REPORT_SIZE(8), HID_REPORT_COUNT(IO4_REPORT_SIZE),
+      HID_OUTPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END
+};
+
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const* tud_hid_descriptor_report_cb(uint8_t itf) {
-  (void)itf;
-  return desc_hid_report_key;
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+  return itf == HID_INSTANCE_IO4 ? desc_hid_report_io4 : desc_hid_report_key;
+#endif
+
+  (void)itf;  // each mode has a single HID interface
+  return usb_output_mode == OUTPUT_MODE_KEYBOARD ? desc_hid_report_key
+                                                 : desc_hid_report_io4;
 }
 
 //--------------------------------------------------------------------+
 // Configuration Descriptor
 //--------------------------------------------------------------------+
 
+// Keyboard mode: the keyboard, and the serial port for logging
+enum
+{
+  ITF_KEY_NUM_HID = 0,
+  ITF_KEY_NUM_CDC_0,
+  ITF_KEY_NUM_CDC_0_DATA,
+  ITF_KEY_NUM_TOTAL
+};
+
+// Arcade mode: the serial port for logging, the slider and the two LED boards,
+// and the IO4
 enum
 {
-	ITF_NUM_HID = 0,
-  ITF_NUM_CDC_0,
+  ITF_NUM_CDC_0 = 0,
   ITF_NUM_CDC_0_DATA,
   ITF_NUM_CDC_1,
   ITF_NUM_CDC_1_DATA,
@@ -96,11 +179,50 @@ enum
   ITF_NUM_CDC_2_DATA,
   ITF_NUM_CDC_3,
   ITF_NUM_CDC_3_DATA,
+  ITF_NUM_IO4,
   ITF_NUM_TOTAL
 };
 
-// #define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
-#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + CFG_TUD_CDC * TUD_CDC_DESC_LEN)
+// Each CDC takes a control and a data interface
+_Static_assert(ITF_KEY_NUM_TOTAL == 2 * KEY_CDC_COUNT + KEY_HID_COUNT,
+               "keyboard interfaces don't match KEY_CDC_COUNT/KEY_HID_COUNT");
+_Static_assert(ITF_NUM_TOTAL == 2 * ARCADE_CDC_COUNT + ARCADE_HID_COUNT,
+               "arcade interfaces don't match ARCADE_CDC_COUNT/ARCADE_HID_COUNT");
+
+#define CONFIG_KEY_TOTAL_LEN                                     \
+  (TUD_CONFIG_DESC_LEN + KEY_HID_COUNT * TUD_HID_DESC_LEN +      \
+   KEY_CDC_COUNT * TUD_CDC_DESC_LEN)
+#define CONFIG_ARCADE_TOTAL_LEN                                  \
+  (TUD_CONFIG_DESC_LEN + ARCADE_HID_COUNT * TUD_HID_INOUT_DESC_LEN + \
+   ARCADE_CDC_COUNT * TUD_CDC_DESC_LEN)
+
+// How often the host polls the CDC notification endpoints, in ms. Nothing is
+// ever sent on them, so they're polled as rarely as full speed allows, rather
+// than every 16ms like TUD_CDC_DESCRIPTOR does.
+#define CDC_NOTIF_INTERVAL 255
+
+// Same as TUD_CDC_DESCRIPTOR, apart from the notification polling interval
+#define CDC_DESCRIPTOR(_itfnum, _stridx, _ep_notif, _ep_notif_size, _epout, _epin, _epsize) \
+  /* Interface Associate */\
+  8, TUSB_DESC_INTERFACE_ASSOCIATION, _itfnum, 2, TUSB_CLASS_CDC, CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL, CDC_COMM_PROTOCOL_NONE, 0,\
+  /* CDC Control Interface */\
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_CDC, CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL, CDC_COMM_PROTOCOL_NONE, _stridx,\
+  /* CDC Header */\
+  5, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_HEADER, U16_TO_U8S_LE(0x0120),\
+  /* CDC Call */\
+  5, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_CALL_MANAGEMENT, 0, (uint8_t)((_itfnum) + 1),\
+  /* CDC ACM: support line request */\
+  4, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_ABSTRACT_CONTROL_MANAGEMENT, 2,\
+  /* CDC Union */\
+  5, TUSB_DESC_CS_INTERFACE, CDC_FUNC_DESC_UNION, _itfnum, (uint8_t)((_itfnum) + 1),\
+  /* Endpoint Notification */\
+  7, TUSB_DESC_ENDPOINT, _ep_notif, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_ep_notif_size), CDC_NOTIF_INTERVAL,\
+  /* CDC Data Interface */\
+  9, TUSB_DESC_INTERFACE, (uint8_t)((_itfnum)+1), 0, 2, TUSB_CLASS_CDC_DATA, 0, 0, 0,\
+  /* Endpoint Out */\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  /* Endpoint In */\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
 
 #define EPNUM_HID 0x89
 
@@ -120,45 +242,117 @@ enum
 #define EPNUM_CDC_3_OUT     0x08
 #define EPNUM_CDC_3_IN      0x88
 
+#define EPNUM_IO4_OUT       0x0A
+#define EPNUM_IO4_IN        0x8A
+
 uint8_t const desc_configuration_key[] = {
     // Config number, interface count, string index, total length, attribute,
     // power in mA
-    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN,
+    TUD_CONFIG_DESCRIPTOR(1, ITF_KEY_NUM_TOTAL, 0, CONFIG_KEY_TOTAL_LEN,
                           TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
     // HID: Interface number, string index, protocol, report descriptor len, EP In
     // address, size & polling interval
-    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE,
+    TUD_HID_DESCRIPTOR(ITF_KEY_NUM_HID, 0, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report_key), EPNUM_HID,
                        CFG_TUD_HID_EP_BUFSIZE, 1),
-    
+
     // CDC 0: Interface number, string index, EP notification address and size,
     // EP data address (out, in) and size.
-    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, 4, EPNUM_CDC_0_NOTIF, 8,
-                       EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64),
-    
+    CDC_DESCRIPTOR(ITF_KEY_NUM_CDC_0, 4, EPNUM_CDC_0_NOTIF, 8,
+                   EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64)
+};
+
+uint8_t const desc_configuration_arcade[] = {
+    // Config number, interface count, string index, total length, attribute,
+    // power in mA
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_ARCADE_TOTAL_LEN,
+                          TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+
+    // CDC 0: Interface number, string index, EP notification address and size,
+    // EP data address (out, in) and size.
+    CDC_DESCRIPTOR(ITF_NUM_CDC_0, 4, EPNUM_CDC_0_NOTIF, 8,
+                   EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64),
+
     // CDC 1: Interface number, string index, EP notification address and size,
     // EP data address (out, in) and size.
-    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, 4, EPNUM_CDC_1_NOTIF, 8,
-                       EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64),
-    
+    CDC_DESCRIPTOR(ITF_NUM_CDC_1, 4, EPNUM_CDC_1_NOTIF, 8,
+                   EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64),
+
     // CDC 2: Interface number, string index, EP notification address and size,
     // EP data address (out, in) and size.
-    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_2, 4, EPNUM_CDC_2_NOTIF, 8,
-                       EPNUM_CDC_2_OUT, EPNUM_CDC_2_IN, 64),
-    
+    CDC_DESCRIPTOR(ITF_NUM_CDC_2, 4, EPNUM_CDC_2_NOTIF, 8,
+                   EPNUM_CDC_2_OUT, EPNUM_CDC_2_IN, 64),
+
     // CDC 3: Interface number, string index, EP notification address and size,
     // EP data address (out, in) and size.
-    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_3, 4, EPNUM_CDC_3_NOTIF, 8,
-                       EPNUM_CDC_3_OUT, EPNUM_CDC_3_IN, 64)
+    CDC_DESCRIPTOR(ITF_NUM_CDC_3, 4, EPNUM_CDC_3_NOTIF, 8,
+                   EPNUM_CDC_3_OUT, EPNUM_CDC_3_IN, 64),
+
+    // IO4: Interface number, string index, protocol, report descriptor len,
+    // EP Out & In address, size & polling interval
+    TUD_HID_INOUT_DESCRIPTOR(ITF_NUM_IO4, 5, HID_ITF_PROTOCOL_NONE,
+                             sizeof(desc_hid_report_io4), EPNUM_IO4_OUT,
+                             EPNUM_IO4_IN, CFG_TUD_HID_EP_BUFSIZE, 1)
 };
 
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+// The configuration used in both modes before they were split, with the stock
+// 16ms CDC notification interval, only for measuring against
+enum
+{
+  ITF_COMBINED_NUM_HID = 0,
+  ITF_COMBINED_NUM_CDC_0,
+  ITF_COMBINED_NUM_CDC_0_DATA,
+  ITF_COMBINED_NUM_CDC_1,
+  ITF_COMBINED_NUM_CDC_1_DATA,
+  ITF_COMBINED_NUM_CDC_2,
+  ITF_COMBINED_NUM_CDC_2_DATA,
+  ITF_COMBINED_NUM_CDC_3,
+  ITF_COMBINED_NUM_CDC_3_DATA,
+  ITF_COMBINED_NUM_IO4,
+  ITF_COMBINED_NUM_TOTAL
+};
+
+#define CONFIG_COMBINED_TOTAL_LEN                                \
+  (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + 4 * TUD_CDC_DESC_LEN + \
+   TUD_HID_INOUT_DESC_LEN)
+
+uint8_t const desc_configuration_combined[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_COMBINED_NUM_TOTAL, 0, CONFIG_COMBINED_TOTAL_LEN,
+                          TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+    TUD_HID_DESCRIPTOR(ITF_COMBINED_NUM_HID, 0, HID_ITF_PROTOCOL_NONE,
+                       sizeof(desc_hid_report_key), EPNUM_HID,
+                       CFG_TUD_HID_EP_BUFSIZE, 1),
+    TUD_CDC_DESCRIPTOR(ITF_COMBINED_NUM_CDC_0, 4, EPNUM_CDC_0_NOTIF, 8,
+                       EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64),
+    TUD_CDC_DESCRIPTOR(ITF_COMBINED_NUM_CDC_1, 4, EPNUM_CDC_1_NOTIF, 8,
+                       EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64),
+    TUD_CDC_DESCRIPTOR(ITF_COMBINED_NUM_CDC_2, 4, EPNUM_CDC_2_NOTIF, 8,
+                       EPNUM_CDC_2_OUT, EPNUM_CDC_2_IN, 64),
+    TUD_CDC_DESCRIPTOR(ITF_COMBINED_NUM_CDC_3, 4, EPNUM_CDC_3_NOTIF, 8,
+                       EPNUM_CDC_3_OUT, EPNUM_CDC_3_IN, 64),
+    TUD_HID_INOUT_DESCRIPTOR(ITF_COMBINED_NUM_IO4, 5, HID_ITF_PROTOCOL_NONE,
+                             sizeof(desc_hid_report_io4), EPNUM_IO4_OUT,
+                             EPNUM_IO4_IN, CFG_TUD_HID_EP_BUFSIZE, 1)
+};
+#endif
+
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const* tud_descriptor_configuration_cb(uint8_t index) {
   (void)index;  // for multiple configurations
-  return desc_configuration_key;
+
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+  return desc_configuration_combined;
+#endif
+
+  if (usb_output_mode == OUTPUT_MODE_KEYBOARD) {
+    return desc_configuration_key;
+  }
+
+  return desc_configuration_arcade;
 }
 
 //--------------------------------------------------------------------+
@@ -171,7 +365,8 @@ char const* string_desc_arr[] = {
     "skogaby",                     // 1: Manufacturer
     "SKOGASLIDER",                 // 2: Product
     "RP2040",                      // 3: Serials, should use chip ID
-    "SKOGASLIDER Serial"           // 4. CDC interface
+    "SKOGASLIDER Serial",          // 4. CDC interface
+    "SKOGASLIDER IO4"              // 5. IO4 interface
 };
 
 static uint16_t _desc_str[64];
@@ -211,15 +406,3 @@ uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
 
   return _desc_str;
 }
-
-uint16_t tud_hid_get_report_cb(
-    uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen
-) {
-    return 0;
-}
-
-void tud_hid_set_report_cb(
-    uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize
-) {
-    return;
-}
@@ -11,6 +11,41 @@ enum {
   REPORT_ID_MOUSE,
 };
 
+// Output modes. Each mode enumerates with only the interfaces it uses, under
+// its own product ID.
+enum {
+  OUTPUT_MODE_ARCADE = 0,
+  OUTPUT_MODE_KEYBOARD,
+  OUTPUT_MODE_COUNT
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The mode the descriptors are served for, set once at boot before the device
+// connects to the host
+extern uint8_t usb_output_mode;
+
+#ifdef __cplusplus
+}
+#endif
+
+// HID interfaces. Each mode has a single HID interface, so both are instance 0,
+// except in the combined baseline configuration, which has both.
+#define HID_INSTANCE_KEYBOARD 0
+#ifdef USB_COMBINED_DESCRIPTOR_BASELINE
+#define HID_INSTANCE_IO4 1
+#else
+#define HID_INSTANCE_IO4 0
+#endif
+
+// IO4 emulation reports, see sega_hardware/io4/protocol.h
+#define IO4_REPORT_ID_INPUT 0x01
+#define IO4_REPORT_ID_RESPONSE 0x02
+#define IO4_REPORT_ID_COMMAND 0x10
+#define IO4_REPORT_SIZE 63
+
 // because they are missing from tusb_hid.h
 #define HID_STRING_INDEX(x) HID_REPORT_ITEM(x, 7, RI_TYPE_LOCAL, 1)
 #define HID_STRING_INDEX_N(x, n) HID_REPORT_ITEM(x, 7, RI_TYPE_LOCAL, n)
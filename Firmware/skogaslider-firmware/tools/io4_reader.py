@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+@file io4_reader.py
+@author skogaby <skogabyskogaby@gmail.com>
+@date 2022-08-22
+@brief Stands in for the game when testing the IO4 emulation in arcade mode. Opens the IO4 HID interface, sends the
+setup commands a game sends, then decodes the input reports and prints the air beams, switches and coin count whenever
+they change, along with how many reports arrive per second (which should be around 1000).
+
+Needs hidapi (pip install hidapi). On Linux the hidraw node has to be readable by the user running this.
+
+    python3 io4_reader.py [--seconds N]
+@copyright Copyright (c) skogaby 2022
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import hid
+
+# Matches idVendor in the device descriptors in tinyusb/usb_descriptors.c
+USB_VID = 0x1337
+
+# The IO4's report descriptor is on the vendor-defined usage page, which tells it apart from the keyboard. Not every
+# hidapi backend reports usage pages, so its interface number in arcade mode (after the four CDC ports, two interfaces
+# each) is used too, see tinyusb/usb_descriptors.c
+IO4_USAGE_PAGE = 0xFF00
+ITF_NUM_IO4 = 8
+
+# Report IDs and size, see tinyusb/usb_descriptors.h
+IO4_REPORT_ID_INPUT = 0x01
+IO4_REPORT_ID_RESPONSE = 0x02
+IO4_REPORT_ID_COMMAND = 0x10
+IO4_REPORT_SIZE = 63
+
+# Command IDs and status values, see sega_hardware/io4/protocol.h
+IO4_SET_COMM_TIMEOUT = 0x01
+IO4_SET_SAMPLING_COUNT = 0x02
+IO4_CLEAR_BOARD_STATUS = 0x03
+IO4_SYSTEM_STATUS_READY = 0x30
+
+# Switch bits in the first button word, and the air beam bits (bottom to top) in the second one
+IO4_BUTTON_TEST = 1 << 9
+IO4_BUTTON_SERVICE = 1 << 6
+NUM_AIR_SENSORS = 6
+
+# The layout of Io4InputReport: 8 ADCs, 4 spinners, 2 chutes and 2 button words, then the two status bytes
+INPUT_REPORT = struct.Struct("<8H4H2H2HBB29x")
+assert INPUT_REPORT.size == IO4_REPORT_SIZE
+
+
+def find_io4():
+    """Returns the hidapi path of the IO4 interface, or None if no controller with one is plugged in."""
+    for device in hid.enumerate(USB_VID):
+        if device["usage_page"] == IO4_USAGE_PAGE or device["interface_number"] == ITF_NUM_IO4:
+            return device["path"]
+    return None
+
+
+def send_command(device, command, payload=b""):
+    """Sends a command as an output report, and waits for the response report that echoes its command ID."""
+    report = bytes([IO4_REPORT_ID_COMMAND, command]) + payload
+    device.write(report.ljust(IO4_REPORT_SIZE + 1, b"\x00"))
+
+    deadline = time.monotonic() + 1.0
+    while time.monotonic() < deadline:
+        data = device.read(IO4_REPORT_SIZE + 1, 100)
+        if data and data[0] == IO4_REPORT_ID_RESPONSE and data[1] == command:
+            return bytes(data[2:])
+
+    raise RuntimeError(f"no response to command 0x{command:02X}")
+
+
+def decode(data):
+    """Turns an input report (without its report ID) into the beam, switch and coin states."""
+    fields = INPUT_REPORT.unpack(bytes(data[:IO4_REPORT_SIZE]))
+    chute, buttons, system_status = fields[12], fields[14:16], fields[16]
+
+    # The switches are active-low, so a set bit means released
+    pressed = [~word & 0xFFFF for word in buttons]
+    return {
+        "beams": [bool(pressed[1] & (1 << i)) for i in range(NUM_AIR_SENSORS)],
+        "test": bool(pressed[0] & IO4_BUTTON_TEST),
+        "service": bool(pressed[0] & IO4_BUTTON_SERVICE),
+        "coins": chute >> 8,
+        "ready": system_status == IO4_SYSTEM_STATUS_READY,
+    }
+
+
+def describe(state):
+    beams = "".join("#" if blocked else "." for blocked in state["beams"])
+    return (f"air {beams} | test {int(state['test'])} | service {int(state['service'])} | "
+            f"coins {state['coins']} | ready {int(state['ready'])}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Reads the IO4 emulation of a controller in arcade mode.")
+    parser.add_argument("--seconds", type=float, default=0, help="stop after this long (default: run until Ctrl+C)")
+    args = parser.parse_args()
+
+    path = find_io4()
+    if path is None:
+        sys.exit(f"No IO4 interface found on VID 0x{USB_VID:04X}, is the controller in arcade mode?")
+
+    device = hid.device()
+    device.open_path(path)
+
+    try:
+        # The same setup a game does: the board only reports itself ready once it's been configured
+        send_command(device, IO4_SET_COMM_TIMEOUT, bytes([200]))
+        send_command(device, IO4_SET_SAMPLING_COUNT, bytes([1]))
+        send_command(device, IO4_CLEAR_BOARD_STATUS)
+        print("IO4 configured, reading inputs")
+
+        last_state = None
+        reports = 0
+        started = window_start = time.monotonic()
+
+        while not args.seconds or time.monotonic() - started < args.seconds:
+            data = device.read(IO4_REPORT_SIZE + 1, 100)
+            if data and data[0] == IO4_REPORT_ID_INPUT:
+                reports += 1
+                state = decode(data[1:])
+                if state != last_state:
+                    print(describe(state))
+                    last_state = state
+
+            now = time.monotonic()
+            if now - window_start >= 1.0:
+                print(f"{reports / (now - window_start):.0f} reports/s")
+                reports = 0
+                window_start = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        device.close()
+
+
+if __name__ == "__main__":
+    main()
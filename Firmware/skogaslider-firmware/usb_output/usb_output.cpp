@@ -37,20 +37,32 @@ void UsbOutput::set_slider_sensors(bool states[32]) {
 
 /**
  * @brief Sets the states for all of the air tower sensors in the USB report.
- * @param states The states of all 6 air sensors.
+ * @param states The states of all 6 air sensors, one bit per beam from the bottom.
  */
-void UsbOutput::set_air_sensors(bool states[6]) {
+void UsbOutput::set_air_sensors(uint8_t states) {
     for (int i = 0; i < 6; i++) {
-        if (states[i]) {
+        if (bit_read(states, i)) {
             set_keycode_pressed(air_key_codes[i]);
         }
     }
 }
 
+/**
+ * @brief Sets the states for the test, service and function buttons in the USB report.
+ * @param states The states of the buttons, one bit per button in the order of the Button enum.
+ */
+void UsbOutput::set_buttons(uint8_t states) {
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        if (bit_read(states, i)) {
+            set_keycode_pressed(button_key_codes[i]);
+        }
+    }
+}
+
 /**
  * @brief Sends the keyboard output to the computer.
  */
 void UsbOutput::send_update() {
-    tud_hid_n_report(0x00, REPORT_ID_KEYBOARD, &nkro_report, sizeof(nkro_report));
+    tud_hid_n_report(HID_INSTANCE_KEYBOARD, REPORT_ID_KEYBOARD, &nkro_report, sizeof(nkro_report));
     memset(&nkro_report, 0, sizeof(nkro_report));
 }
@@ -9,6 +9,7 @@
 
 #include <stdlib.h>
 #include "tusb.h"
+#include "../buttons/buttons.h"
 #include "../tinyusb/usb_descriptors.h"
 
 /**
@@ -33,6 +34,14 @@ const uint8_t air_key_codes[6] = {
     HID_KEY_BACKSLASH, HID_KEY_SLASH, HID_KEY_MINUS, HID_KEY_COMMA, HID_KEY_SEMICOLON, HID_KEY_PERIOD
 };
 
+/**
+ * @brief These are the keycodes that get output for the test, service and function buttons, in the order of the
+ * Button enum. These match the default test, service and coin keys of the common PC loaders.
+ */
+const uint8_t button_key_codes[NUM_BUTTONS] = {
+    HID_KEY_F1, HID_KEY_F2, HID_KEY_F3
+};
+
 /**
  * @brief Class which is responsible for managing sending USB keyboard outputs to the computer based on
  * the touch inputs and air sensor inputs.
@@ -45,6 +54,7 @@ class UsbOutput {
     public:
         UsbOutput();
         void set_slider_sensors(bool states[32]);
-        void set_air_sensors(bool states[6]);
+        void set_air_sensors(uint8_t states);
+        void set_buttons(uint8_t states);
         void send_update();
 };